@@ -0,0 +1,234 @@
+#include "autotune.h"
+#include "kernels.h"
+#include "program_cache.h"
+#include "runtime.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+const char TUNE_MAGIC[] = "OCLTUNE1";
+
+// Device, driver and kernel source: a new driver or kernel invalidates the geometry
+std::string tuneKey(const cl::Device& device)
+{
+	return device.getInfo<CL_DEVICE_NAME>() + "|" + device.getInfo<CL_DRIVER_VERSION>() + "|"
+		+ toHex(fnv1a64(kernelTunable));
+}
+
+std::string tunePath(const std::string& dir, const std::string& key)
+{
+	return dir + "/" + toHex(fnv1a64(key)) + ".tune";
+}
+
+bool loadConfig(const std::string& path, const std::string& key, LaunchConfig& cfg)
+{
+	std::ifstream in(path);
+	std::string magic, storedKey;
+	if (!std::getline(in, magic) || magic != TUNE_MAGIC)
+		return false;
+	if (!std::getline(in, storedKey) || storedKey != key)
+		return false;
+
+	LaunchConfig read;
+	if (!(in >> read.local >> read.vectorWidth >> read.perItem >> read.ms) || !read.vectorWidth || !read.perItem)
+		return false;
+	cfg = read;
+	return true;
+}
+
+void storeConfig(const std::string& path, const std::string& key, const LaunchConfig& cfg)
+{
+	// Write aside and rename, so a concurrent reader never sees a partial or missing file
+	const std::string tmp = tempPathFor(path);
+	{
+		std::ofstream out(tmp, std::ios::trunc);
+		if (!out)
+			return;
+		out << TUNE_MAGIC << "\n" << key << "\n"
+			<< cfg.local << " " << cfg.vectorWidth << " " << cfg.perItem << " " << cfg.ms << "\n";
+	}
+	replaceFile(tmp, path);
+}
+
+// Median kernel time of a configuration in ms, negative when the device refuses it
+class Trial
+{
+public:
+	Trial(Runtime& rt, size_t n)
+		: m_rt(rt)
+		, m_queue(rt.context(), rt.device(), CL_QUEUE_PROFILING_ENABLE)
+		, m_n(n)
+	{
+		std::vector<double> a(n), b(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			a[i] = 0.5 + (i % 1000) * 0.01;
+			b[i] = -10.0 + (i % 997) * 0.02;
+		}
+		const size_t bytes = n * sizeof(double);
+		m_A = cl::Buffer(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, a.data());
+		m_B = cl::Buffer(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, b.data());
+		m_C = cl::Buffer(rt.context(), CL_MEM_WRITE_ONLY, bytes);
+	}
+
+	double time(const LaunchConfig& cfg)
+	{
+		try {
+			cl::Kernel kernel(m_rt.program(kernelTunable, cfg.options()), "entry_point");
+			if (cfg.local && cfg.local > kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(m_rt.device()))
+				return -1.0;
+
+			enqueueCL_Pow(m_queue, kernel, cfg, m_n, m_A, m_B, m_C).wait();
+			std::vector<double> ms;
+			for (int r = 0; r < 3; ++r)
+			{
+				cl::Event done = enqueueCL_Pow(m_queue, kernel, cfg, m_n, m_A, m_B, m_C);
+				done.wait();
+				ms.push_back((done.getProfilingInfo<CL_PROFILING_COMMAND_END>()
+					- done.getProfilingInfo<CL_PROFILING_COMMAND_START>()) * 1e-6);
+			}
+			return percentile(ms, 50.0);
+		}
+		catch (const cl::Error&) {
+			return -1.0;
+		}
+	}
+
+private:
+	Runtime& m_rt;
+	cl::CommandQueue m_queue;
+	size_t m_n;
+	cl::Buffer m_A, m_B, m_C;
+};
+
+} // namespace
+
+std::string LaunchConfig::options() const
+{
+	return "-DVEC=" + std::to_string(vectorWidth) + " -DEPT=" + std::to_string(perItem);
+}
+
+size_t LaunchConfig::globalSize(size_t n) const
+{
+	const size_t vectors = n / vectorWidth;
+	const size_t items = std::max((vectors + perItem - 1) / perItem, n % vectorWidth);
+	return local ? (items + local - 1) / local * local : items;
+}
+
+std::string toString(const LaunchConfig& cfg)
+{
+	std::ostringstream s;
+	s << "local " << (cfg.local ? std::to_string(cfg.local) : std::string("auto")) << ", double"
+		<< cfg.vectorWidth << " x " << cfg.perItem << " per work-item";
+	return s.str();
+}
+
+cl::Event enqueueCL_Pow(const cl::CommandQueue& queue, cl::Kernel& kernel, const LaunchConfig& cfg,
+	size_t n, const Operand& a, const Operand& b, const cl::Buffer& c)
+{
+	kernel.setArg(0, static_cast<cl_ulong>(n));
+	a.setArg(kernel, 1);
+	b.setArg(kernel, 2);
+	kernel.setArg(3, c);
+
+	cl::Event done;
+	queue.enqueueNDRangeKernel(kernel, cl::NullRange, cfg.globalSize(n), cfg.localRange(), nullptr, &done);
+	return done;
+}
+
+unsigned vectorCL_Width(const cl::Device& device)
+{
+	cl_uint width = device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE>();
+	if (!width)
+		width = device.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE>();
+
+	unsigned w = 1;
+	while (w < 8 && w * 2 <= width)
+		w *= 2;
+	return w;
+}
+
+LaunchConfig deviceCL_LaunchConfig(const cl::Device& device)
+{
+	LaunchConfig cfg;
+	cfg.vectorWidth = vectorCL_Width(device);
+	return cfg;
+}
+
+LaunchConfig tuneCL_LaunchConfig(Runtime& rt, size_t sampleElems)
+{
+	const cl::Device& device = rt.device();
+	const size_t maxAlloc = static_cast<size_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()) / sizeof(double);
+	Trial trial(rt, std::max<size_t>(1, std::min(sampleElems, maxAlloc)));
+
+	// Scalar, the device's width and twice that; doubles have no wider vectors than 8
+	const unsigned preferred = vectorCL_Width(device);
+	std::vector<unsigned> widths{ 1 };
+	for (unsigned w : { preferred, preferred * 2 })
+	{
+		if (w > 1 && w <= 8 && std::find(widths.begin(), widths.end(), w) == widths.end())
+			widths.push_back(w);
+	}
+
+	LaunchConfig best;
+	best.ms = -1.0;
+	auto consider = [&](const LaunchConfig& cfg) {
+		double ms = trial.time(cfg);
+		if (ms >= 0.0 && (best.ms < 0.0 || ms < best.ms))
+		{
+			best = cfg;
+			best.ms = ms;
+		}
+	};
+
+	for (unsigned w : widths)
+	{
+		for (unsigned perItem : { 1u, 2u, 4u, 8u })
+		{
+			LaunchConfig cfg;
+			cfg.vectorWidth = w;
+			cfg.perItem = perItem;
+			consider(cfg);
+		}
+	}
+	if (best.ms < 0.0)
+		throw std::runtime_error("No launch configuration of the tunable kernel runs on " + device.getInfo<CL_DEVICE_NAME>());
+
+	// Work-group sizes for the winner: powers of two times the preferred multiple
+	cl::Kernel kernel(rt.program(kernelTunable, best.options()), "entry_point");
+	const size_t limit = std::min<size_t>(device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>(),
+		kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+	const size_t multiple = std::max<size_t>(1,
+		kernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(device));
+	const LaunchConfig shape = best;
+	for (size_t local = multiple; local <= limit; local *= 2)
+	{
+		LaunchConfig cfg = shape;
+		cfg.local = local;
+		consider(cfg);
+	}
+
+	return best;
+}
+
+LaunchConfig getCL_LaunchConfig(Runtime& rt, bool retune)
+{
+	const std::string dir = getCL_CacheDir();
+	const std::string key = tuneKey(rt.device());
+	const std::string path = dir.empty() ? std::string() : tunePath(dir, key);
+
+	LaunchConfig cfg;
+	if (!retune && !path.empty() && loadConfig(path, key, cfg))
+		return cfg;
+
+	cfg = tuneCL_LaunchConfig(rt);
+	if (!path.empty())
+		storeConfig(path, key, cfg);
+	return cfg;
+}
@@ -0,0 +1,55 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include "ocl_common.h"
+#include "operand.h"
+
+#include <cstddef>
+#include <string>
+
+class Runtime;
+
+// Launch geometry of kernelTunable
+struct LaunchConfig
+{
+	size_t local{ 0 };          // work-group size, 0 leaves it to the driver
+	unsigned vectorWidth{ 1 };  // elements per vector load
+	unsigned perItem{ 1 };      // vectors per work-item
+	double ms{ 0.0 };           // kernel time measured when tuning
+
+	// Build options which select the variant, for buffer operands
+	std::string options() const;
+
+	// The same for the operand kinds of pow(a, b)
+	std::string options(const Operand& a, const Operand& b) const { return options() + a.option("A") + b.option("B"); }
+
+	// Global size covering n elements, a multiple of 'local'
+	size_t globalSize(size_t n) const;
+
+	cl::NDRange localRange() const { return local ? cl::NDRange(local) : cl::NullRange; }
+};
+
+std::string toString(const LaunchConfig& cfg);
+
+// Enqueue kernelTunable built with cfg.options(a, b) over n elements
+cl::Event enqueueCL_Pow(const cl::CommandQueue& queue, cl::Kernel& kernel, const LaunchConfig& cfg,
+	size_t n, const Operand& a, const Operand& b, const cl::Buffer& c);
+
+// Vector width of the device for doubles: CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE, the native
+// width when no preference is reported, rounded down to 1, 2, 4 or 8
+unsigned vectorCL_Width(const cl::Device& device);
+
+// Untuned variant from the device capabilities: its vector width, one vector per work-item
+LaunchConfig deviceCL_LaunchConfig(const cl::Device& device);
+
+// Time the candidates on the runtime's device and return the fastest. Vector width and work per
+// item are searched first with the driver's work-group size, then the work-group size for them.
+// Vector widths are scalar, vectorCL_Width() and twice that; work-group sizes are multiples of
+// CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE up to the kernel and device limits.
+LaunchConfig tuneCL_LaunchConfig(Runtime& rt, size_t sampleElems = size_t(1) << 22);
+
+// Configuration saved in the program cache directory for this device and driver, tuned and
+// saved when there is none (or 'retune' is set). Without a cache directory it tunes every time.
+LaunchConfig getCL_LaunchConfig(Runtime& rt, bool retune = false);
+
+#endif // AUTOTUNE_H
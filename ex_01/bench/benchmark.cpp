@@ -0,0 +1,337 @@
+// Size sweep of kernel1: warmups, then repeated runs timed per phase on a profiling queue.
+// Sizes which fit one allocation run as a single pass (write A and B, kernel, read C), larger
+// ones through powCL_Stream, whose phases overlap and are reported as summed device time.
+//
+// The device is the first double precision GPU of any OpenCL 1.2 or later platform, a CPU on
+// a GPU-less machine, e.g. pocl (whose current versions report OpenCL 3.0);
+// POCL_MEMORY_LIMIT=<GiB> lowers its CL_DEVICE_MAX_MEM_ALLOC_SIZE, hence the host memory needed
+// to sweep past it.
+
+#include "ocl_common.h"
+#include "device_info.h"
+#include "kernels.h"
+#include "profiling.h"
+#include "program_cache.h"
+#include "runtime.h"
+#include "stream_pipeline.h"
+#include "utils.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+	size_t minN{ 1024 };
+	size_t maxN{ 0 }; // 0: twice the elements of CL_DEVICE_MAX_MEM_ALLOC_SIZE
+	unsigned factor{ 4 };
+	int warmup{ 2 };
+	int reps{ 10 };
+	size_t chunk{ size_t(1) << 22 };
+	unsigned depth{ 3 };
+	std::string csv;
+	std::string json;
+};
+
+const char* USAGE =
+	"Usage: ex_01_bench [--min <elements>] [--max <elements>] [--factor <step>]\n"
+	"                   [--warmup <runs>] [--reps <runs>] [--chunk <elements>] [--depth <buffer sets>]\n"
+	"                   [--csv <file>] [--json <file>]";
+
+Options parseOptions(int argc, char* argv[])
+{
+	Options opt;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		auto text = [&]() -> std::string {
+			if (i + 1 >= argc)
+				throw std::invalid_argument(arg + " needs a value\n" + USAGE);
+			return argv[++i];
+		};
+		auto value = [&]() -> unsigned long long { return std::stoull(text(), nullptr, 0); };
+
+		if (arg == "--min")
+			opt.minN = static_cast<size_t>(value());
+		else if (arg == "--max")
+			opt.maxN = static_cast<size_t>(value());
+		else if (arg == "--factor")
+			opt.factor = static_cast<unsigned>(value());
+		else if (arg == "--warmup")
+			opt.warmup = static_cast<int>(value());
+		else if (arg == "--reps")
+			opt.reps = static_cast<int>(value());
+		else if (arg == "--chunk")
+			opt.chunk = static_cast<size_t>(value());
+		else if (arg == "--depth")
+			opt.depth = static_cast<unsigned>(value());
+		else if (arg == "--csv")
+			opt.csv = text();
+		else if (arg == "--json")
+			opt.json = text();
+		else
+			throw std::invalid_argument("Unknown option " + arg + "\n" + USAGE);
+	}
+	if (!opt.minN || opt.factor < 2 || opt.reps < 1)
+		throw std::invalid_argument(std::string("Need --min > 0, --factor > 1 and --reps > 0\n") + USAGE);
+	return opt;
+}
+
+struct Stat
+{
+	double median;
+	double p95;
+};
+
+Stat stat(const std::vector<double>& samples)
+{
+	Stat s;
+	s.median = percentile(samples, 50.0);
+	s.p95 = percentile(samples, 95.0);
+	return s;
+}
+
+struct Result
+{
+	size_t n;
+	bool streamed;
+	Stat h2d, kernel, d2h, total; // device time per phase, wall time end to end
+	uint64_t maxUlp;              // against std::pow, on a sample of the elements
+};
+
+// Repeats of one size; fills the phase samples
+class SizeRun
+{
+public:
+	SizeRun(Runtime& rt, const cl::Program& program, const Options& opt, size_t n, size_t maxAllocElems)
+		: m_rt(rt)
+		, m_program(program)
+		, m_opt(opt)
+		, m_n(n)
+		, m_streamed(n > maxAllocElems)
+		, m_a(n)
+		, m_b(n)
+		, m_c(n)
+	{
+		// Bases in [0, 10), exponents in [-20, 20), the same for every driver
+		std::mt19937_64 gen(n);
+		std::uniform_real_distribution<double> base(0.0, 10.0), exponent(-20.0, 20.0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			m_a[i] = base(gen);
+			m_b[i] = exponent(gen);
+		}
+
+		if (!m_streamed)
+		{
+			const size_t bytes = n * sizeof(double);
+			m_A = cl::Buffer(rt.context(), CL_MEM_READ_ONLY, bytes);
+			m_B = cl::Buffer(rt.context(), CL_MEM_READ_ONLY, bytes);
+			m_C = cl::Buffer(rt.context(), CL_MEM_WRITE_ONLY, bytes);
+			m_kernel = cl::Kernel(program, "entry_point");
+			m_kernel.setArg(0, static_cast<cl_ulong>(n));
+			m_kernel.setArg(1, m_A);
+			m_kernel.setArg(2, m_B);
+			m_kernel.setArg(3, m_C);
+		}
+	}
+
+	Result run()
+	{
+		for (int r = 0; r < m_opt.warmup; ++r)
+			once();
+
+		std::vector<double> h2d, kernel, d2h, total;
+		for (int r = 0; r < m_opt.reps; ++r)
+		{
+			total.push_back(once());
+			h2d.push_back(m_profiler.deviceMs(Profiler::Write));
+			kernel.push_back(m_profiler.deviceMs(Profiler::Kernel));
+			d2h.push_back(m_profiler.deviceMs(Profiler::Read));
+		}
+
+		Result res;
+		res.n = m_n;
+		res.streamed = m_streamed;
+		res.h2d = stat(h2d);
+		res.kernel = stat(kernel);
+		res.d2h = stat(d2h);
+		res.total = stat(total);
+
+		res.maxUlp = 0;
+		const size_t step = std::max<size_t>(1, m_n / 65536);
+		for (size_t i = 0; i < m_n; i += step)
+			res.maxUlp = std::max(res.maxUlp, ulpDistance(m_c[i], std::pow(m_a[i], m_b[i])));
+		return res;
+	}
+
+private:
+	// One end to end pass, wall time in ms; the commands are left in m_profiler
+	double once()
+	{
+		m_profiler.clear();
+		Stopwatch sw;
+		if (m_streamed)
+		{
+			powCL_Stream(m_rt.context(), m_rt.device(), m_program, m_a.data(), m_b.data(), m_c.data(), m_n,
+				m_opt.chunk, m_opt.depth, &m_profiler);
+			return sw.elapsedMs();
+		}
+
+		const cl::CommandQueue& queue = m_rt.queue();
+		const size_t bytes = m_n * sizeof(double);
+		cl::Event writeA, writeB, computed, read;
+		queue.enqueueWriteBuffer(m_A, CL_FALSE, 0, bytes, m_a.data(), nullptr, &writeA);
+		queue.enqueueWriteBuffer(m_B, CL_FALSE, 0, bytes, m_b.data(), nullptr, &writeB);
+		queue.enqueueNDRangeKernel(m_kernel, cl::NullRange, m_n, cl::NullRange, nullptr, &computed);
+		queue.enqueueReadBuffer(m_C, CL_TRUE, 0, bytes, m_c.data(), nullptr, &read);
+		double ms = sw.elapsedMs();
+
+		m_profiler.record("write A", Profiler::Write, writeA, bytes);
+		m_profiler.record("write B", Profiler::Write, writeB, bytes);
+		m_profiler.record("entry_point", Profiler::Kernel, computed, m_n);
+		m_profiler.record("read C", Profiler::Read, read, bytes);
+		return ms;
+	}
+
+	Runtime& m_rt;
+	const cl::Program& m_program;
+	const Options& m_opt;
+	size_t m_n;
+	bool m_streamed;
+	std::vector<double> m_a, m_b, m_c;
+	cl::Buffer m_A, m_B, m_C;
+	cl::Kernel m_kernel;
+	Profiler m_profiler;
+};
+
+void printRow(std::ostream& os, const Result& r)
+{
+	const double bytes = static_cast<double>(r.n) * sizeof(double);
+	os << r.n << (r.streamed ? " streamed" : " single")
+		<< ": h2d " << r.h2d.median << "/" << r.h2d.p95
+		<< " kernel " << r.kernel.median << "/" << r.kernel.p95
+		<< " d2h " << r.d2h.median << "/" << r.d2h.p95
+		<< " total " << r.total.median << "/" << r.total.p95 << " ms (median/p95)";
+	if (r.kernel.median > 0.0)
+		os << ", " << r.n / r.kernel.median * 1e-6 << " G elements/s";
+	if (r.h2d.median > 0.0)
+		os << ", h2d " << 2.0 * bytes / r.h2d.median * 1e-6 << " GB/s";
+	os << ", max " << r.maxUlp << " ULP\n";
+}
+
+void writeCsv(const std::string& path, const cl::Device& device, const std::vector<Result>& results)
+{
+	std::ofstream out(path);
+	if (!out)
+		throw std::runtime_error("Can't write " + path);
+
+	const std::string name = device.getInfo<CL_DEVICE_NAME>();
+	const std::string driver = device.getInfo<CL_DRIVER_VERSION>();
+	out << "device,driver,n,mode,h2d_median_ms,h2d_p95_ms,kernel_median_ms,kernel_p95_ms,"
+		"d2h_median_ms,d2h_p95_ms,total_median_ms,total_p95_ms,max_ulp\n";
+	for (auto& r : results)
+	{
+		out << '"' << name << "\",\"" << driver << "\"," << r.n << "," << (r.streamed ? "stream" : "single")
+			<< "," << r.h2d.median << "," << r.h2d.p95 << "," << r.kernel.median << "," << r.kernel.p95
+			<< "," << r.d2h.median << "," << r.d2h.p95 << "," << r.total.median << "," << r.total.p95
+			<< "," << r.maxUlp << "\n";
+	}
+}
+
+void writeJson(const std::string& path, const cl::Device& device, const Options& opt, double buildMs,
+	const std::vector<Result>& results)
+{
+	std::ofstream out(path);
+	if (!out)
+		throw std::runtime_error("Can't write " + path);
+
+	auto json = [](const Stat& s) {
+		return "{\"median_ms\":" + std::to_string(s.median) + ",\"p95_ms\":" + std::to_string(s.p95) + "}";
+	};
+
+	cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
+	out << "{\"device\":\"" << jsonEscape(device.getInfo<CL_DEVICE_NAME>()) << "\""
+		<< ",\"driver\":\"" << jsonEscape(device.getInfo<CL_DRIVER_VERSION>()) << "\""
+		<< ",\"platform\":\"" << jsonEscape(platform.getInfo<CL_PLATFORM_VERSION>()) << "\""
+		<< ",\"max_mem_alloc\":" << device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()
+		<< ",\"build_ms\":" << buildMs
+		<< ",\"warmup\":" << opt.warmup << ",\"reps\":" << opt.reps
+		<< ",\"chunk\":" << opt.chunk << ",\"depth\":" << opt.depth
+		<< ",\"results\":[";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const Result& r = results[i];
+		out << (i ? ",\n" : "\n")
+			<< "{\"n\":" << r.n << ",\"mode\":\"" << (r.streamed ? "stream" : "single") << "\""
+			<< ",\"h2d\":" << json(r.h2d) << ",\"kernel\":" << json(r.kernel) << ",\"d2h\":" << json(r.d2h)
+			<< ",\"total\":" << json(r.total) << ",\"max_ulp\":" << r.maxUlp << "}";
+	}
+	out << "\n]}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+try
+{
+	const Options opt = parseOptions(argc, argv);
+
+	Runtime rt(getCL_AnyDevice(), true);
+	const cl::Device& device = rt.device();
+	const size_t maxAllocElems = static_cast<size_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()) / sizeof(double);
+	const size_t maxN = opt.maxN ? opt.maxN : 2 * maxAllocElems;
+
+	std::cout << device.getInfo<CL_DEVICE_NAME>() << ", driver " << device.getInfo<CL_DRIVER_VERSION>()
+		<< ", max allocation " << maxAllocElems << " elements\n";
+
+	bool cached = false;
+	Stopwatch build;
+	cl::Program program = buildCL_Program(rt.context(), device, kernel1, std::string(), &cached);
+	const double buildMs = build.elapsedMs();
+	std::cout << "Program ready in " << buildMs << " ms" << (cached ? " (cached binary)" : "") << "\n";
+
+	// Geometric steps from the minimum, the maximum itself last
+	std::vector<size_t> sizes;
+	for (size_t n = opt.minN; n < maxN; n *= opt.factor)
+	{
+		sizes.push_back(n);
+		if (n > maxN / opt.factor)
+			break;
+	}
+	sizes.push_back(maxN);
+
+	std::vector<Result> results;
+	for (size_t n : sizes)
+	{
+		SizeRun sizeRun(rt, program, opt, n, maxAllocElems);
+		results.push_back(sizeRun.run());
+		printRow(std::cout, results.back());
+	}
+
+	if (!opt.csv.empty())
+		writeCsv(opt.csv, device, results);
+	if (!opt.json.empty())
+		writeJson(opt.json, device, opt, buildMs, results);
+
+	return 0;
+}
+catch (const cl::Error &err) {
+	std::cerr << "OpenCL error: " << err.what() << "(" << err.err() << ")\n";
+	return 1;
+}
+catch (const std::exception &err) {
+	std::cerr << "STD exception: " << err.what() << "\n";
+	return 2;
+}
+catch (...)
+{
+	std::cerr << "Unknown exception\n";
+	return 3;
+}
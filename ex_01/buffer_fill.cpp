@@ -0,0 +1,34 @@
+#include "buffer_fill.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+cl::Event fillCL_Buffer(const cl::CommandQueue& queue, const cl::Buffer& buffer, const void* pattern,
+	size_t patternSize, size_t offset, size_t bytes)
+{
+	if (!patternSize)
+		throw std::invalid_argument("Filling a buffer with an empty pattern");
+
+	cl::Event done;
+	if (!bytes)
+		return done;
+
+	const bool pow2 = !(patternSize & (patternSize - 1));
+	if (pow2 && patternSize <= 128 && !(offset % patternSize) && !(bytes % patternSize))
+	{
+		// The template in cl2.hpp takes the pattern size from its type, this takes any
+		cl_event event;
+		const cl_int err = ::clEnqueueFillBuffer(queue(), buffer(), pattern, patternSize, offset, bytes, 0, nullptr,
+			&event);
+		if (err != CL_SUCCESS)
+			throw cl::Error(err, "clEnqueueFillBuffer");
+		return cl::Event(event);
+	}
+
+	size_t filled = std::min(patternSize, bytes);
+	queue.enqueueWriteBuffer(buffer, CL_TRUE, offset, filled, pattern, nullptr, &done);
+	for (; filled < bytes; filled *= 2)
+		queue.enqueueCopyBuffer(buffer, buffer, offset, offset + filled, std::min(filled, bytes - filled), nullptr,
+			&done);
+	return done;
+}
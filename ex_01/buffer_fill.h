@@ -0,0 +1,16 @@
+#ifndef BUFFER_FILL_H
+#define BUFFER_FILL_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+
+// Enqueue filling 'bytes' bytes of 'buffer' from 'offset' with copies of 'pattern'
+// ('patternSize' bytes), the last one cut short if it doesn't fit. Patterns of 1, 2, 4, ..., 128
+// bytes dividing 'offset' and 'bytes' go to clEnqueueFillBuffer; any other is written once
+// (blocking, it is small) and doubled with copies within the buffer, log2(bytes / patternSize)
+// of them. Only the pattern passes through host memory. The event is that of the last command.
+cl::Event fillCL_Buffer(const cl::CommandQueue& queue, const cl::Buffer& buffer, const void* pattern,
+	size_t patternSize, size_t offset, size_t bytes);
+
+#endif // BUFFER_FILL_H
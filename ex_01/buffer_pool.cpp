@@ -0,0 +1,161 @@
+#include "buffer_pool.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const size_t MIN_CLASS = 4096;
+
+// Smallest power of two not below n
+size_t ceilPow2(size_t n)
+{
+	size_t p = 1;
+	while (p < n)
+		p *= 2;
+	return p;
+}
+
+} // namespace
+
+BufferPool::Lease::Lease(BufferPool* pool, cl::Buffer buffer, size_t capacity, cl_mem_flags flags)
+	: m_pool(pool)
+	, m_buffer(std::move(buffer))
+	, m_capacity(capacity)
+	, m_flags(flags)
+{
+}
+
+BufferPool::Lease::Lease(Lease&& other)
+	: m_pool(other.m_pool)
+	, m_buffer(std::move(other.m_buffer))
+	, m_capacity(other.m_capacity)
+	, m_flags(other.m_flags)
+{
+	other.m_pool = nullptr;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other)
+{
+	if (this != &other)
+	{
+		release();
+		m_pool = other.m_pool;
+		m_buffer = std::move(other.m_buffer);
+		m_capacity = other.m_capacity;
+		m_flags = other.m_flags;
+		other.m_pool = nullptr;
+	}
+	return *this;
+}
+
+void BufferPool::Lease::release()
+{
+	if (!m_pool)
+		return;
+	m_pool->giveBack(std::move(m_buffer), m_capacity, m_flags);
+	m_pool = nullptr;
+	m_buffer = cl::Buffer();
+}
+
+BufferPool::BufferPool(const cl::Context& context, size_t maxRetained)
+	: m_context(context)
+	, m_maxAlloc(std::numeric_limits<size_t>::max())
+{
+	uint64_t global = std::numeric_limits<uint64_t>::max();
+	for (const cl::Device& device : context.getInfo<CL_CONTEXT_DEVICES>())
+	{
+		global = std::min(global, device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>());
+		m_maxAlloc = std::min(m_maxAlloc, static_cast<size_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()));
+	}
+	m_stats.maxRetained = maxRetained ? maxRetained : static_cast<size_t>(global / 2);
+}
+
+size_t BufferPool::capacity(size_t bytes) const
+{
+	// Above the largest allocation the device allows a request only shares with its own size
+	const size_t rounded = ceilPow2(std::max(bytes, MIN_CLASS));
+	return rounded <= m_maxAlloc ? rounded : bytes;
+}
+
+BufferPool::Lease BufferPool::acquire(size_t bytes, cl_mem_flags flags)
+{
+	if (!bytes)
+		throw std::invalid_argument("Leasing a buffer of 0 bytes");
+	if (flags & (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR))
+		throw std::invalid_argument("Pooled buffers can't have a host pointer");
+
+	const size_t size = capacity(bytes);
+	const SizeClass key(flags, size);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_free.find(key);
+		if (it != m_free.end() && !it->second.empty())
+		{
+			cl::Buffer buffer = std::move(it->second.back());
+			it->second.pop_back();
+			m_stats.retainedBytes -= size;
+			m_stats.leasedBytes += size;
+			++m_stats.hits;
+			return Lease(this, std::move(buffer), size, flags);
+		}
+		++m_stats.misses;
+	}
+
+	// Created outside the lock, other threads keep being served meanwhile
+	cl::Buffer buffer;
+	try {
+		buffer = cl::Buffer(m_context, flags, size);
+	}
+	catch (const cl::Error& err) {
+		if (err.err() != CL_MEM_OBJECT_ALLOCATION_FAILURE && err.err() != CL_OUT_OF_RESOURCES
+			&& err.err() != CL_OUT_OF_HOST_MEMORY)
+			throw;
+		trim();
+		buffer = cl::Buffer(m_context, flags, size);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.leasedBytes += size;
+	return Lease(this, std::move(buffer), size, flags);
+}
+
+void BufferPool::giveBack(cl::Buffer buffer, size_t capacity, cl_mem_flags flags)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.leasedBytes -= capacity;
+	if (m_stats.retainedBytes + capacity > m_stats.maxRetained)
+	{
+		++m_stats.dropped;
+		return;
+	}
+	m_free[SizeClass(flags, capacity)].push_back(std::move(buffer));
+	m_stats.retainedBytes += capacity;
+}
+
+void BufferPool::trim()
+{
+	std::map<SizeClass, std::vector<cl::Buffer>> released;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		released.swap(m_free);
+		m_stats.retainedBytes = 0;
+	}
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+std::string toString(const BufferPool::Stats& s)
+{
+	const double MiB = 1024.0 * 1024.0;
+	std::ostringstream out;
+	out << s.hits << " hits, " << s.misses << " misses, " << s.dropped << " dropped, " << s.leasedBytes / MiB
+		<< " MiB leased, " << s.retainedBytes / MiB << " of " << s.maxRetained / MiB << " MiB retained";
+	return out.str();
+}
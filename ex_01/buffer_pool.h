@@ -0,0 +1,94 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Device buffers of one context kept for reuse between jobs, so a job doesn't pay
+// clCreateBuffer / clReleaseMemObject (and the driver's allocator) for its operands. Requests
+// round up to a power of two, at least 4 KiB, and buffers are shared by requests of the same
+// size class and memory flags. Leases give them back when they go out of scope; the pool keeps
+// them up to a cap on the total and releases the rest. Thread safe. The contents of a leased
+// buffer are undefined, and a lease must only end when the commands using the buffer are done
+// or are on the in-order queue its next users submit to.
+class BufferPool
+{
+public:
+	struct Stats
+	{
+		uint64_t hits{ 0 };        // leases served by a retained buffer
+		uint64_t misses{ 0 };      // leases which created one
+		uint64_t dropped{ 0 };     // buffers released on return, the cap being reached
+		size_t leasedBytes{ 0 };   // out on leases now
+		size_t retainedBytes{ 0 }; // kept for reuse now
+		size_t maxRetained{ 0 };
+	};
+
+	// A buffer on loan, returned to its pool on destruction or release()
+	class Lease
+	{
+	public:
+		Lease() = default;
+		Lease(Lease&& other);
+		Lease& operator=(Lease&& other);
+		~Lease() { release(); }
+
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+
+		const cl::Buffer& buffer() const { return m_buffer; }
+		size_t capacity() const { return m_capacity; }
+
+		void release();
+
+	private:
+		friend class BufferPool;
+		Lease(BufferPool* pool, cl::Buffer buffer, size_t capacity, cl_mem_flags flags);
+
+		BufferPool* m_pool{ nullptr };
+		cl::Buffer m_buffer;
+		size_t m_capacity{ 0 };
+		cl_mem_flags m_flags{ 0 };
+	};
+
+	// Pool for 'context', retaining at most 'maxRetained' bytes: 0 for half of the smallest
+	// CL_DEVICE_GLOBAL_MEM_SIZE among its devices
+	explicit BufferPool(const cl::Context& context, size_t maxRetained = 0);
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	// A buffer of at least 'bytes' bytes with 'flags', which may not have a host pointer. When
+	// creating one fails for lack of memory the retained buffers are released and it is tried
+	// once more.
+	Lease acquire(size_t bytes, cl_mem_flags flags = CL_MEM_READ_WRITE);
+
+	// Release every retained buffer
+	void trim();
+
+	Stats stats() const;
+
+private:
+	// Memory flags and capacity
+	typedef std::pair<uint64_t, size_t> SizeClass;
+
+	size_t capacity(size_t bytes) const;
+	void giveBack(cl::Buffer buffer, size_t capacity, cl_mem_flags flags);
+
+	cl::Context m_context;
+	size_t m_maxAlloc;
+	mutable std::mutex m_mutex;
+	std::map<SizeClass, std::vector<cl::Buffer>> m_free;
+	Stats m_stats;
+};
+
+std::string toString(const BufferPool::Stats& s);
+
+#endif // BUFFER_POOL_H
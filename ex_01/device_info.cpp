@@ -0,0 +1,486 @@
+#include "device_info.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+CLver CLver_num[] {v100, v110, v120, v200, v210, v220};
+const char* CLver_str[] {"OpenCL 1.0", "OpenCL 1.1", "OpenCL 1.2", "OpenCL 2.0", "OpenCL 2.1", "OpenCL 2.2"};
+
+CLver getCL_ver(const std::string& ver)
+{
+	CLver cur_ver{ vUnknown };
+	for (CLver v : CLver_num)
+	{
+		if (ver.find(CLver_str[v]) == 0)
+		{
+			cur_ver = v;
+		}
+	}
+	return cur_ver;
+}
+    
+namespace {
+
+// "OpenCL <major>.<minor> <platform specific>" as major * 10 + minor, 0 when it doesn't parse
+int versionCL_Number(const std::string& ver)
+{
+	const std::string prefix = "OpenCL ";
+	if (ver.compare(0, prefix.size(), prefix) != 0)
+		return 0;
+	const char* major = ver.c_str() + prefix.size();
+	const char* dot = std::strchr(major, '.');
+	return dot ? std::atoi(major) * 10 + std::atoi(dot + 1) : 0;
+}
+
+// Devices of the type, none rather than CL_DEVICE_NOT_FOUND
+std::vector<cl::Device> devicesOf(const cl::Platform& platform, cl_device_type type)
+{
+	std::vector<cl::Device> devices;
+	try {
+		platform.getDevices(type, &devices);
+	}
+	catch (const cl::Error& e) {
+		if (e.err() != CL_DEVICE_NOT_FOUND)
+			throw;
+	}
+	return devices;
+}
+
+std::vector<cl::Device> doubleDevices(const cl::Platform& platform)
+{
+	std::vector<cl::Device> devices;
+	for (auto& d : devicesOf(platform, CL_DEVICE_TYPE_ALL))
+	{
+		if (d.getInfo<CL_DEVICE_AVAILABLE>() && hasCL_DoublePrecision(d))
+			devices.push_back(d);
+	}
+	return devices;
+}
+
+bool hasIntelSubGroups(const cl::Device& dev)
+{
+	return dev.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_intel_subgroups") != std::string::npos;
+}
+
+} // namespace
+
+void printCL_PlatformInfo(const cl::Platform& platform)
+{
+    std::string info;
+    std::cout << "\n=====================================\n";
+    std::cout << "========== PLATFORM INFO ============\n";
+    if (platform.getInfo(CL_PLATFORM_PROFILE, &info) == CL_SUCCESS)
+        std::cout << "PROFILE: " << info << "\n";
+    if (platform.getInfo(CL_PLATFORM_VERSION, &info) == CL_SUCCESS)
+        std::cout << "VERSION: " << info << "\n";
+    if (platform.getInfo(CL_PLATFORM_NAME, &info) == CL_SUCCESS)
+        std::cout << "NAME: " << info << "\n";
+    if (platform.getInfo(CL_PLATFORM_VENDOR, &info) == CL_SUCCESS)
+        std::cout << "VENDOR: " << info << "\n";
+    if (platform.getInfo(CL_PLATFORM_EXTENSIONS, &info) == CL_SUCCESS)
+        std::cout << "EXTENSIONS: " << info << "\n";
+    std::cout << "=====================================\n";
+}
+    
+void printCL_DeviceInfo(const cl::Device& dev)
+{
+    std::cout << "\n+++++++++++++++++++++++++++++++++++++";
+    std::cout << "\n+++++++++++ DEVICE INFO +++++++++++++";
+    std::cout << "\nTYPE: ";
+    switch(dev.getInfo<CL_DEVICE_TYPE>())
+    {
+        case CL_DEVICE_TYPE_CPU:
+            std::cout << "CPU";
+            break;
+        case CL_DEVICE_TYPE_GPU:
+            std::cout << "GPU";
+            break;
+        case CL_DEVICE_TYPE_ACCELERATOR:
+            std::cout << "ACCELERATOR";
+            break;
+        case CL_DEVICE_TYPE_DEFAULT:
+            std::cout << "DEFAULT";
+            break;
+    }
+    std::cout << " || VENDOR_ID: " << dev.getInfo<CL_DEVICE_VENDOR_ID>();
+    std::cout << " || NAME: " << dev.getInfo<CL_DEVICE_NAME>();
+    std::cout << " || VENDOR: " << dev.getInfo<CL_DEVICE_VENDOR>();
+    std::cout << " || DRIVER_VERSION: " << dev.getInfo<CL_DRIVER_VERSION>();
+    std::cout << " || PROFILE: " << dev.getInfo<CL_DEVICE_PROFILE>();
+    std::cout << " || VERSION: " << dev.getInfo<CL_DEVICE_VERSION>();
+    std::cout << " || PLATFORM: " << dev.getInfo<CL_DEVICE_PLATFORM>();
+    std::cout << " || AVAILABLE: " << (dev.getInfo<CL_DEVICE_AVAILABLE>() ? "YES" : "NO");
+    std::cout << " || COMPILER_AVAILABLE: " << (dev.getInfo<CL_DEVICE_COMPILER_AVAILABLE>() ? "YES" : "NO");
+    std::cout << " || OPENCL_C_VERSION: " << dev.getInfo<CL_DEVICE_OPENCL_C_VERSION>();
+    std::cout << " || PARENT_DEVICE: ";
+    auto parent = dev.getInfo<CL_DEVICE_PARENT_DEVICE>();
+	std::cout << (parent.get() ? parent.get() : 0);
+    std::cout << " || ADDRESS_BITS: " << dev.getInfo<CL_DEVICE_ADDRESS_BITS>();
+    std::cout << " || MEM_BASE_ADDR_ALIGN: " << dev.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>();
+    std::cout << " || MIN_DATA_TYPE_ALIGN_SIZE: " << dev.getInfo<CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE>();
+    std::cout << " || CONSTANT_BUFFER_SIZE: " << dev.getInfo<CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE>();
+    std::cout << " || ERROR_CORRECTION_SUPPORT: " << (dev.getInfo<CL_DEVICE_ERROR_CORRECTION_SUPPORT>() ? "YES" : "NO");
+    std::cout << " || PROFILING_TIMER_RESOLUTION: " << dev.getInfo<CL_DEVICE_PROFILING_TIMER_RESOLUTION>();
+    std::cout << " || ENDIAN_LITTLE: " << (dev.getInfo<CL_DEVICE_ENDIAN_LITTLE>() ? "YES" : "NO");
+    std::cout << " || EXECUTION_CAPABILITIES: ";
+    switch(dev.getInfo<CL_DEVICE_EXECUTION_CAPABILITIES>())
+    {
+        case CL_EXEC_KERNEL:
+            std::cout << "KERNEL";
+            break;
+        case CL_EXEC_NATIVE_KERNEL:
+            std::cout << "NATIVE_KERNEL";
+            break;
+            
+    }
+    std::cout << " || QUEUE_PROPERTIES: ";
+    switch(dev.getInfo<CL_DEVICE_QUEUE_PROPERTIES>())
+    {
+        case CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE:
+            std::cout << "OUT_OF_ORDER_EXEC_MODE_ENABLE";
+            break;
+        case CL_QUEUE_PROFILING_ENABLE:
+            std::cout << "PROFILING_ENABLE";
+            break;
+    }
+    std::cout << " || HOST_UNIFIED_MEMORY: " << (dev.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() ? "YES" : "NO");
+    std::cout << " || BUILT_IN_KERNELS: " << dev.getInfo<CL_DEVICE_BUILT_IN_KERNELS>();
+    std::cout << " || REFERENCE_COUNT: " << dev.getInfo<CL_DEVICE_REFERENCE_COUNT>();
+    //std::cout << " || LINKER_AVAILABLE: " << (dev.getInfo<CL_DEVICE_LINKER_AVAILABLE>() ? "YES" : "NO");
+    //std::cout << " || PRINTF_BUFFER_SIZE: " << dev.getInfo<CL_DEVICE_PRINTF_BUFFER_SIZE>();
+    
+    std::cout << "\n= EXTENSIONS =\n" << dev.getInfo<CL_DEVICE_EXTENSIONS>();
+    
+    std::cout << "\n= NATIVE_VECTOR_WIDTH =\nCHAR: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_CHAR>();
+    std::cout << " || SHORT: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_SHORT>();
+    std::cout << " || INT: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_INT>();
+    std::cout << " || LONG: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_LONG>();
+    std::cout << " || FLOAT: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT>();
+    std::cout << " || DOUBLE: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE>();
+    std::cout << " || HALF: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_HALF>();
+    
+    std::cout << "\n= REFERRED_VECTOR_WIDTH =\nCHAR: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR>();
+    std::cout << " || SHORT: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT>();
+    std::cout << " || INT: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT>();
+    std::cout << " || LONG: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG>();
+    std::cout << " || FLOAT: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT>();
+    std::cout << " || DOUBLE: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE>();
+    std::cout << " || HALF: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_HALF>();
+    
+    std::cout << "\nPREFERRED_INTEROP_USER_SYNC: " << dev.getInfo<CL_DEVICE_PREFERRED_INTEROP_USER_SYNC>();
+    
+    std::cout << "\n= MAX_WORK =\nITEM_DIMENSIONS: " << dev.getInfo<CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS>();
+    std::cout << " || GROUP_SIZE: " << dev.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+    std::cout << " || ITEM_SIZES: ";
+    auto sizes = dev.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+    for(auto s : sizes)
+    {
+        std::cout << s << ", ";
+    }
+    
+    std::cout << "\n= MAX =\nCOMPUTE_UNITS: " << dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+    std::cout << " || CLOCK_FREQUENCY: " << dev.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>();
+    std::cout << " || READ_IMAGE_ARGS: " << dev.getInfo<CL_DEVICE_MAX_READ_IMAGE_ARGS>();
+    std::cout << " || WRITE_IMAGE_ARGS: " << dev.getInfo<CL_DEVICE_MAX_WRITE_IMAGE_ARGS>();
+    std::cout << " || MEM_ALLOC_SIZE: " << dev.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    std::cout << " || PARAMETER_SIZE: " << dev.getInfo<CL_DEVICE_MAX_PARAMETER_SIZE>();
+    std::cout << " || SAMPLERS: " << dev.getInfo<CL_DEVICE_MAX_SAMPLERS>();
+    std::cout << " || CONSTANT_ARGS: " << dev.getInfo<CL_DEVICE_MAX_CONSTANT_ARGS>();
+    
+    
+    std::cout << "\n= IMAGE =\nSUPPORT: " << (dev.getInfo<CL_DEVICE_IMAGE_SUPPORT>() ? "YES" : "NO");
+    //std::cout << " || MAX_BUFFER_SIZE: " << dev.getInfo<CL_DEVICE_IMAGE_MAX_BUFFER_SIZE>();
+    //std::cout << " || MAX_ARRAY_SIZE: " << dev.getInfo<CL_DEVICE_IMAGE_MAX_ARRAY_SIZE>();
+    //std::cout << " || PITCH_ALIGNMENT: " << dev.getInfo<CL_DEVICE_IMAGE_PITCH_ALIGNMENT>();
+    //std::cout << " || BASE_ADDRESS_ALIGNMENT: " << dev.getInfo<CL_DEVICE_IMAGE_BASE_ADDRESS_ALIGNMENT>();
+    std::cout << " || 2D_MAX_WIDTH: " << dev.getInfo<CL_DEVICE_IMAGE2D_MAX_WIDTH>();
+    std::cout << " || 2D_MAX_HEIGHT: " << dev.getInfo<CL_DEVICE_IMAGE2D_MAX_HEIGHT>();
+    std::cout << " || 3D_MAX_WIDTH: " << dev.getInfo<CL_DEVICE_IMAGE3D_MAX_WIDTH>();
+    std::cout << " || 3D_MAX_HEIGHT: " << dev.getInfo<CL_DEVICE_IMAGE3D_MAX_HEIGHT>();
+    std::cout << " || 3D_MAX_DEPTH: " << dev.getInfo<CL_DEVICE_IMAGE3D_MAX_DEPTH>();
+    
+    std::cout << "\n= LOCAL_MEM =\nTYPE: ";
+    switch(dev.getInfo<CL_DEVICE_LOCAL_MEM_TYPE>())
+    {
+        case CL_LOCAL:
+            std::cout << "LOCAL";
+            break;
+        case CL_GLOBAL:
+            std::cout << "GLOBAL";
+            break;
+    }
+    std::cout << " || SIZE: " << dev.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+    
+    std::cout << "\n= GLOBAL_MEM =\nCACHE_TYPE: ";
+    switch(dev.getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_TYPE>())
+    {
+        case CL_NONE:
+            std::cout << "NONE";
+            break;
+        case CL_READ_ONLY_CACHE:
+            std::cout << "ONLY_CACHE";
+            break;
+        case CL_READ_WRITE_CACHE:
+            std::cout << "READ_WRITE_CACHE";
+            break;
+    }
+    std::cout << " || CACHELINE_SIZE: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE>();
+    std::cout << " || CACHE_SIZE: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_SIZE>();
+    std::cout << " || SIZE: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    
+    
+    std::cout << "\n= FP_CONFIG =\nSINGLE: ";
+	auto single_fp = dev.getInfo<CL_DEVICE_SINGLE_FP_CONFIG>();
+	if (single_fp & CL_FP_DENORM) std::cout << "DENORM" << "|";
+	if (single_fp & CL_FP_INF_NAN) std::cout << "INF_NAN" << "|";
+	if (single_fp & CL_FP_ROUND_TO_NEAREST) std::cout << "ROUND_TO_NEAREST" << "|";
+	if (single_fp & CL_FP_ROUND_TO_ZERO) std::cout << "ROUND_TO_ZERO" << "|";
+	if (single_fp & CL_FP_ROUND_TO_INF) std::cout << "ROUND_TO_INF" << "|";
+	if (single_fp & CL_FP_FMA) std::cout << "FMA" << "|";
+	if (single_fp & CL_FP_SOFT_FLOAT) std::cout << "SOFT_FLOAT" << "|";
+	if (single_fp & CL_FP_CORRECTLY_ROUNDED_DIVIDE_SQRT) std::cout << "CORRECTLY_ROUNDED_DIVIDE_SQRT" << "|";
+    std::cout << "\nDOUBLE: ";
+	auto double_fp = dev.getInfo<CL_DEVICE_DOUBLE_FP_CONFIG>();
+	if (double_fp & CL_FP_DENORM) std::cout << "DENORM" << "|";
+	if (double_fp & CL_FP_INF_NAN) std::cout << "INF_NAN" << "|";
+	if (double_fp & CL_FP_ROUND_TO_NEAREST) std::cout << "ROUND_TO_NEAREST" << "|";
+	if (double_fp & CL_FP_ROUND_TO_ZERO) std::cout << "ROUND_TO_ZERO" << "|";
+	if (double_fp & CL_FP_ROUND_TO_INF) std::cout << "ROUND_TO_INF" << "|";
+	if (double_fp & CL_FP_FMA) std::cout << "FMA" << "|";
+	if (double_fp & CL_FP_SOFT_FLOAT) std::cout << "SOFT_FLOAT" << "|";
+	if (double_fp & CL_FP_CORRECTLY_ROUNDED_DIVIDE_SQRT) std::cout << "CORRECTLY_ROUNDED_DIVIDE_SQRT" << "|";
+    
+	auto partition_affinity_domain = dev.getInfo<CL_DEVICE_PARTITION_AFFINITY_DOMAIN>();
+	if (partition_affinity_domain)
+	{
+		std::cout << "\n= PARTITION =\nAFFINITY_DOMAIN: ";
+		switch (partition_affinity_domain)
+		{
+		case CL_DEVICE_AFFINITY_DOMAIN_NUMA:
+			std::cout << "NUMA";
+			break;
+		case CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE:
+			std::cout << "L4_CACHE";
+			break;
+		case CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE:
+			std::cout << "L3_CACHE";
+			break;
+		case CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE:
+			std::cout << "L2_CACHE";
+			break;
+		case CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE:
+			std::cout << "L1_CACHE";
+			break;
+		case CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE:
+			std::cout << "NEXT_PARTITIONABLE";
+			break;
+		}
+		//std::cout << " || MAX_SUB_DEVICES: " << dev.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>();
+		std::cout << " || PROPERTIES: ";
+		auto partition_properties = dev.getInfo<CL_DEVICE_PARTITION_PROPERTIES>();
+		for (auto pp : partition_properties)
+		{
+			switch (pp)
+			{
+			case CL_DEVICE_PARTITION_EQUALLY:
+				std::cout << "EQUALLY";
+				break;
+			case CL_DEVICE_PARTITION_BY_COUNTS:
+				std::cout << "BY_COUNTS";
+				break;
+			case CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN:
+				std::cout << "BY_AFFINITY_DOMAIN";
+				break;
+			}
+			std::cout << ", ";
+		}
+		std::cout << " || TYPE: ";
+		auto partition_type = dev.getInfo<CL_DEVICE_PARTITION_TYPE>();
+		for (auto pt : partition_type)
+		{
+			std::cout << pt << ", ";
+		}
+	}
+    std::cout << "\n+++++++++++++++++++++++++++++++++++++\n";
+}
+
+void printCL_Devices(const cl::Platform& platform)
+{
+	for (auto d : devicesOf(platform, CL_DEVICE_TYPE_GPU))
+		printCL_DeviceInfo(d);
+	std::cout << std::endl;
+}
+
+bool hasCL_DoublePrecision(const cl::Device& dev)
+{
+	std::string ext = dev.getInfo<CL_DEVICE_EXTENSIONS>();
+	return ext.find("cl_khr_fp64") != std::string::npos || ext.find("cl_amd_fp64") != std::string::npos;
+}
+
+bool hasCL_SubGroups(const cl::Device& dev)
+{
+	if (hasIntelSubGroups(dev))
+		return true;
+	if (dev.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_subgroups") == std::string::npos)
+		return false;
+	// "OpenCL C <major>.<minor> <vendor specific>"
+	const std::string prefix = "OpenCL C ";
+	const std::string ver = dev.getInfo<CL_DEVICE_OPENCL_C_VERSION>();
+	return ver.compare(0, prefix.size(), prefix) == 0 && std::atoi(ver.c_str() + prefix.size()) >= 2;
+}
+
+std::string subGroupCL_Options(const cl::Device& dev)
+{
+	return hasIntelSubGroups(dev) ? std::string() : std::string(" -cl-std=CL2.0");
+}
+
+std::vector<cl::Device> getCL_ComputeDevices(const cl::Platform& platform, unsigned subDevices)
+{
+	std::vector<cl::Device> devices = doubleDevices(platform);
+
+	if (devices.size() == 1 && subDevices > 1)
+	{
+		cl_uint units = devices.front().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+		cl_device_partition_property props[] = {
+			CL_DEVICE_PARTITION_EQUALLY,
+			static_cast<cl_device_partition_property>(std::max<cl_uint>(1, units / subDevices)),
+			0
+		};
+		std::vector<cl::Device> parts;
+		devices.front().createSubDevices(props, &parts);
+		if (parts.size() > subDevices)
+			parts.resize(subDevices);
+		devices.swap(parts);
+	}
+
+	if (devices.empty())
+		throw std::domain_error("Devices with double precision not found.");
+
+	return devices;
+}
+
+cl::Platform getCL_Platform(bool verbose)
+{
+	std::vector<cl::Platform> platforms;
+	cl::Platform::get(&platforms);
+	size_t cur_platform = platforms.size();
+
+	if (!cur_platform)
+	{
+		throw std::domain_error("OpenCL platforms aren't found.");
+	}
+
+	// One with GPUs wins over a later one without, e.g. pocl next to a GPU driver
+	bool cur_gpus = false;
+	for (size_t p = 0; p < platforms.size(); ++p)
+	{
+		if (verbose)
+			printCL_PlatformInfo(platforms.at(p));
+		std::string ver;
+		if (platforms.at(p).getInfo(CL_PLATFORM_VERSION, &ver) == CL_SUCCESS)
+		{
+			if (versionCL_Number(ver) >= 12)
+			{
+				const bool gpus = !devicesOf(platforms.at(p), CL_DEVICE_TYPE_GPU).empty();
+				if (gpus || !cur_gpus)
+				{
+					cur_platform = p;
+					cur_gpus = gpus;
+				}
+				if (verbose)
+					printCL_Devices(platforms.at(p));
+			}
+		}
+	}
+
+	if (cur_platform == platforms.size())
+	{
+		throw std::domain_error("OpenCL 1.2 or later platform is not found.");
+	}
+
+	return std::move(platforms.at(cur_platform));
+}
+
+cl::Device getCL_Device(bool verbose, bool requireDouble)
+{
+	cl::Platform platform = getCL_Platform(verbose);
+
+	std::vector<cl::Device> devices = devicesOf(platform, CL_DEVICE_TYPE_GPU);
+	size_t cur_device = devices.size();
+	size_t any_device = devices.size();
+
+    for (size_t d = 0; d < devices.size(); ++d) {
+		if (!devices[d].getInfo<CL_DEVICE_AVAILABLE>()) continue;
+
+		// Get first available GPU device which supports double precision
+		if (hasCL_DoublePrecision(devices[d]))
+		{
+			cur_device = d;
+			break;
+		}
+		if (any_device == devices.size())
+			any_device = d;
+	}
+
+	if (cur_device == devices.size() && !requireDouble)
+		cur_device = any_device;
+
+	if (cur_device == devices.size())
+	{
+		throw std::domain_error(requireDouble ? "GPUs with double precision not found." : "Available GPUs not found.");
+	}
+    
+	return std::move(devices.at(cur_device));
+}
+
+std::vector<cl::Platform> getCL_Platforms()
+{
+	std::vector<cl::Platform> all, platforms;
+	cl::Platform::get(&all);
+	for (auto& p : all)
+	{
+		if (versionCL_Number(p.getInfo<CL_PLATFORM_VERSION>()) >= 12)
+			platforms.push_back(p);
+	}
+	if (platforms.empty())
+		throw std::domain_error("OpenCL 1.2 or later platform is not found.");
+	return platforms;
+}
+
+cl::Platform getCL_ComputePlatform()
+{
+	std::vector<cl::Platform> platforms = getCL_Platforms();
+	for (size_t p = platforms.size(); p--; )
+	{
+		if (!doubleDevices(platforms[p]).empty())
+			return platforms[p];
+	}
+	throw std::domain_error("Devices with double precision not found.");
+}
+
+cl::Device getCL_AnyDevice()
+{
+	std::vector<cl::Device> devices;
+	for (auto& p : getCL_Platforms())
+	{
+		std::vector<cl::Device> more = doubleDevices(p);
+		devices.insert(devices.end(), more.begin(), more.end());
+	}
+
+	for (cl_device_type type : { cl_device_type(CL_DEVICE_TYPE_GPU), cl_device_type(CL_DEVICE_TYPE_CPU) })
+	{
+		for (auto& d : devices)
+		{
+			if (d.getInfo<CL_DEVICE_TYPE>() & type)
+				return d;
+		}
+	}
+	if (devices.empty())
+		throw std::domain_error("Devices with double precision not found.");
+	return devices.front();
+}
@@ -0,0 +1,60 @@
+#ifndef DEVICE_INFO_H
+#define DEVICE_INFO_H
+
+#include "ocl_common.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum CLver : uint8_t {
+	v100,
+	v110,
+	v120,
+	v200,
+	v210,
+	v220,
+	vUnknown
+};
+
+CLver getCL_ver(const std::string& ver);
+
+void printCL_PlatformInfo(const cl::Platform& platform);
+void printCL_DeviceInfo(const cl::Device& dev);
+void printCL_Devices(const cl::Platform& platform);
+
+// cl_khr_fp64 or cl_amd_fp64 is reported by the device
+bool hasCL_DoublePrecision(const cl::Device& dev);
+
+// The sub-group built-ins (get_sub_group_*, sub_group_reduce_*) are available: from
+// cl_intel_subgroups, which has them on OpenCL 1.2, or from cl_khr_subgroups on a device that
+// compiles OpenCL C 2.0
+bool hasCL_SubGroups(const cl::Device& dev);
+
+// Build options for them: nothing for cl_intel_subgroups, -cl-std=CL2.0 for cl_khr_subgroups
+std::string subGroupCL_Options(const cl::Device& dev);
+
+// Every available double precision device of the platform. When there is a single one and
+// 'subDevices' > 1, it is partitioned into that many equal sub-devices instead, which gives
+// several devices on a CPU-only machine (pocl).
+std::vector<cl::Device> getCL_ComputeDevices(const cl::Platform& platform, unsigned subDevices = 0);
+
+// Last platform at OpenCL 1.2 or later with GPUs, the last one without otherwise; 'verbose'
+// dumps every platform and its GPUs on the way
+cl::Platform getCL_Platform(bool verbose = false);
+
+// First available GPU of that platform which supports double precision. Without one, the first
+// available GPU unless 'requireDouble' is set; see defaultCL_Precision() for such devices.
+cl::Device getCL_Device(bool verbose = false, bool requireDouble = false);
+
+// Every platform at OpenCL 1.2 or later, 2.x and 3.0 ones (current pocl) included
+std::vector<cl::Platform> getCL_Platforms();
+
+// Last of those platforms with an available double precision device, for getCL_ComputeDevices()
+cl::Platform getCL_ComputePlatform();
+
+// First available double precision GPU of any of those platforms, the first such CPU otherwise,
+// then any other such device: runs on a GPU-less machine with pocl
+cl::Device getCL_AnyDevice();
+
+#endif // DEVICE_INFO_H
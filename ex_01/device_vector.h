@@ -0,0 +1,337 @@
+#ifndef DEVICE_VECTOR_H
+#define DEVICE_VECTOR_H
+
+#include "buffer_fill.h"
+#include "expression.h"
+#include "runtime.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ocl {
+
+// n elements of T with a device copy in a buffer of the runtime's context and a host copy,
+// each transferred only when the other side has changed it and it is read. Kernels (assigning
+// an expression, see expression.h, or anything using buffer()) keep the data on the device;
+// single elements and ranges are read and written through maps of just those bytes. Commands
+// go to the runtime's in-order queue, so they see each other's results without waiting on the
+// host. Not thread safe, const access included: it may transfer.
+template<class T>
+class DeviceVector : public Expression<DeviceVector<T>>
+{
+public:
+	typedef T value_type;
+
+	// Uninitialised device copy; 'flags' restrict what kernels may do with it, e.g.
+	// CL_MEM_WRITE_ONLY for a result only read back. With CL_MEM_READ_ONLY it can only be
+	// filled or written from the host, assign() and bufferForWriting() throw.
+	DeviceVector(Runtime& rt, size_t n, cl_mem_flags flags = CL_MEM_READ_WRITE)
+		: m_rt(&rt)
+		, m_size(n)
+		, m_flags(flags)
+		, m_current(Current::Device)
+	{
+		if (n)
+			m_buffer = cl::Buffer(rt.context(), flags, n * sizeof(T));
+	}
+
+	// Host copy 'host', uploaded on first use on the device
+	DeviceVector(Runtime& rt, std::vector<T> host)
+		: DeviceVector(rt, host.size())
+	{
+		m_host = std::move(host);
+		m_current = Current::Host;
+	}
+
+	~DeviceVector() { waitUpload(); }
+
+	DeviceVector(const DeviceVector&) = delete;
+	DeviceVector(DeviceVector&&) = default;
+
+	DeviceVector& operator=(DeviceVector&& other)
+	{
+		if (this != &other)
+		{
+			waitUpload();
+			m_rt = other.m_rt;
+			m_size = other.m_size;
+			m_flags = other.m_flags;
+			m_buffer = std::move(other.m_buffer);
+			m_host = std::move(other.m_host);
+			m_current = other.m_current;
+			m_upload = std::move(other.m_upload);
+		}
+		return *this;
+	}
+
+	// Elementwise copy on the device, the sizes must match
+	DeviceVector& operator=(const DeviceVector& other)
+	{
+		if (this != &other)
+			assign(other);
+		return *this;
+	}
+
+	template<class E>
+	DeviceVector& operator=(const Expression<E>& e)
+	{
+		assign(e);
+		return *this;
+	}
+
+	// Enqueue the kernel of expression e, whose vectors must have this size. The event
+	// completes when the values are in place; the host copy is stale from then on.
+	template<class E>
+	cl::Event assign(const Expression<E>& e)
+	{
+		typedef typename Stored<E>::type Node;
+		const Node node(e.self());
+		const size_t n = node.size();
+		if (n && n != m_size)
+			throw std::invalid_argument("Assigning " + std::to_string(n) + " elements to a vector of "
+				+ std::to_string(m_size));
+
+		checkKernelWritable();
+		cl::Event done;
+		if (!m_size)
+			return done;
+
+		const std::pair<std::string, std::string>& source = fusedSource<Node>();
+		cl::Kernel kernel = fusedCL_Kernel(*m_rt, ClType<T>::name(), source.first, source.second);
+		kernel.setArg(0, static_cast<cl_ulong>(m_size));
+		kernel.setArg(1, m_buffer);
+		cl_uint arg = 2;
+		node.setArgs(kernel, arg);
+		m_rt->queue().enqueueNDRangeKernel(kernel, cl::NullRange, m_size, cl::NullRange, nullptr, &done);
+		m_current = Current::Device;
+		return done;
+	}
+
+	// Device copy for kernels which read it, uploaded first if the host has changed it
+	const cl::Buffer& buffer() const
+	{
+		syncToDevice();
+		return m_buffer;
+	}
+
+	// The same for kernels which write it: the host copy is stale from then on
+	const cl::Buffer& bufferForWriting()
+	{
+		checkKernelWritable();
+		syncToDevice();
+		m_current = Current::Device;
+		return m_buffer;
+	}
+
+	// Enqueue setting every element to 'value' on the device, nothing goes through host memory.
+	// The host copy is stale from then on.
+	cl::Event fill(const T& value) { return fill(&value, 1); }
+
+	// The same with copies of 'count' elements from 'pattern', the last one cut short
+	cl::Event fill(const T* pattern, size_t count)
+	{
+		m_current = Current::Device;
+		return fillCL_Buffer(m_rt->queue(), m_buffer, pattern, count * sizeof(T), 0, m_size * sizeof(T));
+	}
+
+	// Enqueue the upload of the host copy if the device copy is stale. The event is that of the
+	// transfer, empty when nothing was to be done.
+	cl::Event syncToDevice() const
+	{
+		cl::Event uploaded;
+		if (m_current == Current::Host && m_size)
+		{
+			m_rt->queue().enqueueWriteBuffer(m_buffer, CL_FALSE, 0, m_size * sizeof(T), m_host.data(), nullptr,
+				&uploaded);
+			m_upload = uploaded;
+		}
+		if (m_current == Current::Host)
+			m_current = Current::Both;
+		return uploaded;
+	}
+
+	// Read the device copy back if the host copy is stale
+	void syncToHost() const
+	{
+		if (m_current != Current::Device)
+			return;
+		m_host.resize(m_size);
+		if (m_size)
+			m_rt->queue().enqueueReadBuffer(m_buffer, CL_TRUE, 0, m_size * sizeof(T), m_host.data());
+		m_current = Current::Both;
+	}
+
+	// Host copy, current
+	const std::vector<T>& host() const
+	{
+		syncToHost();
+		return m_host;
+	}
+
+	// Host copy to modify: the device copy is stale from then on
+	std::vector<T>& hostForWriting()
+	{
+		syncToHost();
+		waitUpload();
+		m_current = Current::Host;
+		return m_host;
+	}
+
+	// Element i, from the host copy when it is current, otherwise mapped from the device
+	T get(size_t i) const
+	{
+		T value;
+		read(i, 1, &value);
+		return value;
+	}
+
+	// Elements [first, first + count) to 'dst'. When they come from the device, the events of the
+	// map and the unmap are appended to 'events', if given.
+	void read(size_t first, size_t count, T* dst, std::vector<cl::Event>* events = nullptr) const
+	{
+		checkRange(first, count);
+		if (m_current != Current::Device)
+		{
+			std::copy(m_host.begin() + first, m_host.begin() + first + count, dst);
+			return;
+		}
+		if (!count)
+			return;
+		const cl::CommandQueue& queue = m_rt->queue();
+		cl::Event map, unmap;
+		const T* mapped = static_cast<const T*>(queue.enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_READ,
+			first * sizeof(T), count * sizeof(T), nullptr, &map));
+		std::copy(mapped, mapped + count, dst);
+		queue.enqueueUnmapMemObject(m_buffer, const_cast<T*>(mapped), nullptr, &unmap);
+		if (events)
+		{
+			events->push_back(map);
+			events->push_back(unmap);
+		}
+	}
+
+	std::vector<T> read(size_t first, size_t count) const
+	{
+		std::vector<T> values(count);
+		read(first, count, values.data());
+		return values;
+	}
+
+	// Set element i in each copy which is current
+	void set(size_t i, T value) { write(i, 1, &value); }
+
+	// Elements [first, first + count) from 'src', into each copy which is current
+	void write(size_t first, size_t count, const T* src)
+	{
+		checkRange(first, count);
+		if (m_current != Current::Device)
+		{
+			waitUpload();
+			std::copy(src, src + count, m_host.begin() + first);
+		}
+		if (m_current != Current::Host && count)
+		{
+			const cl::CommandQueue& queue = m_rt->queue();
+			T* mapped = static_cast<T*>(queue.enqueueMapBuffer(m_buffer, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION,
+				first * sizeof(T), count * sizeof(T)));
+			std::copy(src, src + count, mapped);
+			queue.enqueueUnmapMemObject(m_buffer, mapped);
+		}
+	}
+
+	// Every element, from the host copy when it is current, read from the device otherwise
+	void copyTo(T* dst) const
+	{
+		if (m_current != Current::Device)
+			std::copy(m_host.begin(), m_host.end(), dst);
+		else if (m_size)
+			m_rt->queue().enqueueReadBuffer(m_buffer, CL_TRUE, 0, m_size * sizeof(T), dst);
+	}
+
+	std::vector<T> toHost() const { return host(); }
+
+	size_t size() const { return m_size; }
+	Runtime& runtime() const { return *m_rt; }
+
+private:
+	// Which copy holds the values
+	enum class Current { Host, Device, Both };
+
+	void checkRange(size_t first, size_t count) const
+	{
+		if (first > m_size || count > m_size - first)
+			throw std::out_of_range("Elements " + std::to_string(first) + " + " + std::to_string(count)
+				+ " of a vector of " + std::to_string(m_size));
+	}
+
+	// Kernels writing a CL_MEM_READ_ONLY buffer are undefined behaviour; fills, writes and
+	// uploads from the host are fine
+	void checkKernelWritable() const
+	{
+		if (m_flags & CL_MEM_READ_ONLY)
+			throw std::logic_error("A kernel can't write a vector created with CL_MEM_READ_ONLY");
+	}
+
+	// The upload reads the host copy asynchronously, it must be done before the copy changes
+	void waitUpload()
+	{
+		if (m_upload())
+		{
+			m_upload.wait();
+			m_upload = cl::Event();
+		}
+	}
+
+	Runtime* m_rt;
+	size_t m_size;
+	cl_mem_flags m_flags;
+	cl::Buffer m_buffer;
+	mutable std::vector<T> m_host;  // empty until the host needs it
+	mutable Current m_current;
+	mutable cl::Event m_upload;
+};
+
+// Leaf of an expression tree: the buffer of a DeviceVector, shared with it
+template<class T>
+class VectorRef
+{
+public:
+	typedef T value_type;
+
+	VectorRef(const DeviceVector<T>& v)
+		: m_buffer(v.buffer())
+		, m_size(v.size())
+	{
+	}
+
+	static void declare(std::string& params, unsigned& leaf)
+	{
+		params += std::string(", global const ") + ClType<T>::name() + " *x" + std::to_string(leaf++);
+	}
+
+	static void code(std::string& body, unsigned& leaf)
+	{
+		body += "x" + std::to_string(leaf++) + "[i]";
+	}
+
+	void setArgs(cl::Kernel& kernel, cl_uint& arg) const { kernel.setArg(arg++, m_buffer); }
+	size_t size() const { return m_size; }
+
+private:
+	cl::Buffer m_buffer;
+	size_t m_size;
+};
+
+template<class T>
+struct Stored<DeviceVector<T>>
+{
+	typedef VectorRef<T> type;
+};
+
+} // namespace ocl
+
+#endif // DEVICE_VECTOR_H
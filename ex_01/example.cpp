@@ -1,430 +1,1448 @@
-#define CL_HPP_ENABLE_EXCEPTIONS
-#define CL_HPP_MINIMUM_OPENCL_VERSION 120
-#define CL_HPP_TARGET_OPENCL_VERSION 120
-#define CL_HPP_CL_1_2_DEFAULT_BUILD
-#define CL_HPP_ENABLE_PROGRAM_CONSTRUCTION_FROM_ARRAY_COMPATIBILITY
-
-#include <CL/cl2.hpp>
+#include "ocl_common.h"
+#include "autotune.h"
+#include "buffer_pool.h"
+#include "device_info.h"
+#include "device_vector.h"
+#include "host_convert.h"
+#include "kernels.h"
+#include "multi_device.h"
+#include "packed_storage.h"
+#include "pow_engine.h"
+#include "pow_paths.h"
+#include "radix_sort.h"
+#include "random.h"
+#include "profiling.h"
+#include "program_cache.h"
+#include "reduced_precision.h"
+#include "reduction.h"
+#include "runtime.h"
+#include "scan.h"
+#include "stream_pipeline.h"
+#include "utils.h"
+#include "validation.h"
+#include "work_stealing.h"
+#include "zero_copy.h"
 
+#include <iomanip>
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <exception>
+#include <stdexcept>
 #include <cstdlib>
 #include <ctime>
+#include <random>
+#include <functional>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+const size_t N = 0xFFFFFF;
 
-// CL program source
-const std::string kernel1{ R"KS1(
-#if defined(cl_khr_fp64)
-#  pragma OPENCL EXTENSION cl_khr_fp64: enable
-#elif defined(cl_amd_fp64)
-#  pragma OPENCL EXTENSION cl_amd_fp64: enable
-#else
-#  error double precision is not supported
-#endif
-kernel
-void entry_point(ulong n, global const double *a,
-        global const double *b, global double *c)
+// Startup cost of kernel1: source build (cold cache) against cached binary (warm cache)
+void benchProgramCache(const cl::Context& context, const cl::Device& device, int reps)
 {
-    size_t id = get_global_id(0);
-    if (id < n)
-       c[id] =  pow(a[id], b[id]);
+	if (getCL_CacheDir().empty())
+	{
+		std::cout << "Program cache is disabled (OCL_NO_CACHE)\n";
+		return;
+	}
+
+	double cold = 0.0;
+	double warm = 0.0;
+	int hits = 0;
+	for (int r = 0; r < reps; ++r)
+	{
+		dropCL_CachedProgram(device, kernel1);
+		Stopwatch sw;
+		cl::Kernel k(buildCL_Program(context, device, kernel1), "entry_point");
+		cold += sw.elapsedMs();
+
+		bool cached = false;
+		sw.restart();
+		cl::Kernel kw(buildCL_Program(context, device, kernel1, std::string(), &cached), "entry_point");
+		warm += sw.elapsedMs();
+		hits += cached ? 1 : 0;
+	}
+
+	std::cout << "Program cache (" << getCL_CacheDir() << "), " << reps << " runs\n";
+	std::cout << "cold (source build): " << cold / reps << " ms\n";
+	std::cout << "warm (binary load):  " << warm / reps << " ms\n";
+	std::cout << "cache hits: " << hits << "/" << reps << "\n";
 }
-)KS1" };
 
-const size_t N = 0xFFFFFF;
+// One job: upload, kernel, blocking readback. The buffers are leased from 'pool' when there
+// is one, created for the job otherwise.
+void powJob(const cl::Context& context, const cl::CommandQueue& queue, cl::Kernel& kernel,
+	const std::vector<double>& a, const std::vector<double>& b, std::vector<double>& c, BufferPool* pool = nullptr)
+{
+	const size_t bytes = a.size() * sizeof(double);
+	BufferPool::Lease leases[3];
+	cl::Buffer A, B, C;
+	if (pool)
+	{
+		leases[0] = pool->acquire(bytes, CL_MEM_READ_ONLY);
+		leases[1] = pool->acquire(bytes, CL_MEM_READ_ONLY);
+		leases[2] = pool->acquire(bytes, CL_MEM_WRITE_ONLY);
+		A = leases[0].buffer();
+		B = leases[1].buffer();
+		C = leases[2].buffer();
+		queue.enqueueWriteBuffer(A, CL_FALSE, 0, bytes, a.data());
+		queue.enqueueWriteBuffer(B, CL_FALSE, 0, bytes, b.data());
+	}
+	else
+	{
+		A = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, const_cast<double*>(a.data()));
+		B = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, const_cast<double*>(b.data()));
+		C = cl::Buffer(context, CL_MEM_WRITE_ONLY, bytes);
+	}
 
-enum CLver : uint8_t {
-	v100,
-	v110,
-	v120,
-	v200,
-	v210,
-	v220,
-	vUnknown
-};
+	kernel.setArg(0, static_cast<cl_ulong>(a.size()));
+	kernel.setArg(1, A);
+	kernel.setArg(2, B);
+	kernel.setArg(3, C);
+	queue.enqueueNDRangeKernel(kernel, cl::NullRange, a.size(), cl::NullRange);
+	queue.enqueueReadBuffer(C, CL_TRUE, 0, bytes, c.data());
+}
 
-CLver CLver_num[] {v100, v110, v120, v200, v210, v220};
-const char* CLver_str[] {"OpenCL 1.0", "OpenCL 1.1", "OpenCL 1.2", "OpenCL 2.0", "OpenCL 2.1", "OpenCL 2.2"};
+void printLatency(const char* title, const std::vector<double>& ms)
+{
+	double sum = 0.0;
+	for (double t : ms)
+		sum += t;
+	std::cout << title << ": mean " << sum / ms.size() << " ms, median " << percentile(ms, 50)
+		<< " ms, p95 " << percentile(ms, 95) << " ms\n";
+}
 
-CLver getCL_ver(const std::string& ver)
+// Per-job latency of small jobs: device, context, queue and program (built from source) set
+// up for every job against jobs submitted to the long lived runtime; then, for small and large
+// jobs on the runtime, buffers created per job against buffers leased from its pool
+void benchRuntime(int jobs)
 {
-	CLver cur_ver{ vUnknown };
-	for (CLver v : CLver_num)
+	const size_t jobSize = 4096;
+	std::vector<double> a(jobSize, 0.1), b(jobSize, 3.0), c(jobSize);
+
+	// Cold means a source build too: the cached binary of kernel1 is dropped before each job
+	const cl::Device target = getCL_Device(false, true);
+	std::vector<double> cold, reused;
+	for (int j = 0; j < jobs; ++j)
+	{
+		dropCL_CachedProgram(target, kernel1);
+		Stopwatch sw;
+		cl::Device device = getCL_Device(false, true);
+		cl::Context context(device);
+		cl::CommandQueue queue(context, device);
+		cl::Kernel kernel(buildCL_Program(context, device, kernel1), "entry_point");
+		powJob(context, queue, kernel, a, b, c);
+		cold.push_back(sw.elapsedMs());
+	}
+
+	// The first job pays for the runtime itself, the measured ones don't
+	Runtime& rt = Runtime::instance();
+	cl::Kernel first = rt.kernel(kernel1, "entry_point");
+	powJob(rt.context(), rt.queue(), first, a, b, c);
+	for (int j = 0; j < jobs; ++j)
+	{
+		Stopwatch sw;
+		cl::Kernel kernel = rt.kernel(kernel1, "entry_point");
+		powJob(rt.context(), rt.queue(), kernel, a, b, c);
+		reused.push_back(sw.elapsedMs());
+	}
+
+	std::cout << jobs << " jobs of " << jobSize << " elements\n";
+	printLatency("cold setup per job", cold);
+	printLatency("reused runtime    ", reused);
+
+	// Large jobs are where allocating per job shows, 128 MiB per operand or what fits
+	const size_t largeSize = clampToAlloc(rt.device(), N);
+	BufferPool& pool = rt.bufferPool();
+	for (size_t size : { jobSize, largeSize })
 	{
-		if (ver.find(CLver_str[v]) == 0)
+		std::vector<double> a(size, 0.1), b(size, 3.0), c(size);
+		std::vector<double> fresh, pooled;
+		powJob(rt.context(), rt.queue(), first, a, b, c, &pool);
+		for (int j = 0; j < jobs; ++j)
 		{
-			cur_ver = v;
+			Stopwatch sw;
+			powJob(rt.context(), rt.queue(), first, a, b, c);
+			fresh.push_back(sw.elapsedMs());
+
+			sw.restart();
+			powJob(rt.context(), rt.queue(), first, a, b, c, &pool);
+			pooled.push_back(sw.elapsedMs());
 		}
+		std::cout << jobs << " jobs of " << size << " elements on the runtime\n";
+		printLatency("buffers per job   ", fresh);
+		printLatency("pooled buffers    ", pooled);
 	}
-	return cur_ver;
+	std::cout << "Pool: " << toString(pool.stats()) << "\n";
 }
-    
-void printCL_PlatformInfo(const cl::Platform& platform)
+
+// Host wall time per launch, enqueue to completion rather than the profiled kernel time, of the
+// scalar, double2, double4 and double8 variants of kernelTunable, one vector per work-item, with
+// their distance from the scalar results
+void benchVectorWidths(Runtime& rt, size_t n)
 {
-    std::string info;
-    std::cout << "\n=====================================\n";
-    std::cout << "========== PLATFORM INFO ============\n";
-    if (platform.getInfo(CL_PLATFORM_PROFILE, &info) == CL_SUCCESS)
-        std::cout << "PROFILE: " << info << "\n";
-    if (platform.getInfo(CL_PLATFORM_VERSION, &info) == CL_SUCCESS)
-        std::cout << "VERSION: " << info << "\n";
-    if (platform.getInfo(CL_PLATFORM_NAME, &info) == CL_SUCCESS)
-        std::cout << "NAME: " << info << "\n";
-    if (platform.getInfo(CL_PLATFORM_VENDOR, &info) == CL_SUCCESS)
-        std::cout << "VENDOR: " << info << "\n";
-    if (platform.getInfo(CL_PLATFORM_EXTENSIONS, &info) == CL_SUCCESS)
-        std::cout << "EXTENSIONS: " << info << "\n";
-    std::cout << "=====================================\n";
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> a = randomVector(n, 0.0, 10.0), b = randomVector(n, -20.0, 20.0, 1), c(n), scalar(n);
+
+	const size_t bytes = n * sizeof(double);
+	const cl::CommandQueue& queue = rt.queue();
+	cl::Buffer A(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, a.data());
+	cl::Buffer B(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, b.data());
+	cl::Buffer C(rt.context(), CL_MEM_WRITE_ONLY, bytes);
+
+	const unsigned selected = vectorCL_Width(device);
+	std::cout << n << " elements on " << device.getInfo<CL_DEVICE_NAME>() << ", preferred double width "
+		<< device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE>() << ", native "
+		<< device.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE>() << ", wall time per launch\n";
+	for (unsigned width : { 1u, 2u, 4u, 8u })
+	{
+		LaunchConfig cfg;
+		cfg.vectorWidth = width;
+		cl::Kernel kernel(rt.program(kernelTunable, cfg.options()), "entry_point");
+
+		// Warm up, then the median of a few runs
+		const double median = medianMs([&] { enqueueCL_Pow(queue, kernel, cfg, n, A, B, C).wait(); }, 5);
+		queue.enqueueReadBuffer(C, CL_TRUE, 0, bytes, width == 1 ? scalar.data() : c.data());
+
+		uint64_t maxUlp = 0;
+		if (width > 1)
+		{
+			for (size_t i = 0; i < n; ++i)
+				maxUlp = std::max(maxUlp, ulpDistance(c[i], scalar[i]));
+		}
+
+		std::cout << (width == 1 ? std::string("scalar ") : "double" + std::to_string(width)) << ": "
+			<< median << " ms, " << n / median * 1e-6 << " G elements/s, max " << maxUlp << " ULP from scalar"
+			<< (width == selected ? "  <- selected" : "") << "\n";
+	}
+}
+
+// pow(a, 3) on each path: the exponent as a scalar argument and as an array of 3.0. Host wall
+// time per launch, enqueue to completion rather than the profiled kernel time.
+void benchIntegerPow(Runtime& rt, size_t n)
+{
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> a = randomVector(n, -10.0, 10.0), b(n, 3.0), c(n);
+
+	const size_t bytes = n * sizeof(double);
+	const cl::CommandQueue& queue = rt.queue();
+	cl::Buffer A(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, a.data());
+	cl::Buffer B(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, b.data());
+	cl::Buffer C(rt.context(), CL_MEM_WRITE_ONLY, bytes);
+	const LaunchConfig launch = deviceCL_LaunchConfig(device);
+
+	struct Case
+	{
+		const char* title;
+		Operand exponent;
+		PowPath path;
+	};
+	const Case cases[] = {
+		{ "scalar 3, general ", Operand(3.0), PowPath::General },
+		{ "scalar 3, selected", Operand(3.0), selectCL_PowPath(rt, Operand(3.0), n) },
+		{ "array 3.0, general ", Operand(B), PowPath::General },
+		{ "array 3.0, selected", Operand(B), selectCL_PowPath(rt, Operand(B), n) },
+	};
+
+	std::cout << n << " elements, base in [-10, 10), " << toString(launch) << ", wall time per launch\n";
+	for (auto& cs : cases)
+	{
+		cl::Kernel kernel = powCL_Kernel(rt, launch, A, cs.exponent, cs.path);
+		// Warm up, then the median of a few runs
+		const double median = medianMs([&] { enqueueCL_Pow(queue, kernel, launch, n, A, cs.exponent, C).wait(); }, 5);
+		queue.enqueueReadBuffer(C, CL_TRUE, 0, bytes, c.data());
+
+		uint64_t maxUlp = 0;
+		for (size_t i = 0; i < n; ++i)
+			maxUlp = std::max(maxUlp, ulpDistance(c[i], std::pow(a[i], 3.0)));
+
+		std::cout << cs.title << " (" << toString(cs.path) << "): " << median << " ms, " << n / median * 1e-6
+			<< " G elements/s, max " << maxUlp << " ULP from std::pow\n";
+	}
 }
-    
-void printCL_DeviceInfo(const cl::Device& dev)
+
+// Error and host wall time per launch (enqueue to completion rather than the profiled kernel
+// time) of every math mode on the general path, against a long double reference; bases and
+// exponents are positive and small enough for single precision
+void benchMathModes(Runtime& rt, size_t n, double tolerance)
 {
-    std::cout << "\n+++++++++++++++++++++++++++++++++++++";
-    std::cout << "\n+++++++++++ DEVICE INFO +++++++++++++";
-    std::cout << "\nTYPE: ";
-    switch(dev.getInfo<CL_DEVICE_TYPE>())
-    {
-        case CL_DEVICE_TYPE_CPU:
-            std::cout << "CPU";
-            break;
-        case CL_DEVICE_TYPE_GPU:
-            std::cout << "GPU";
-            break;
-        case CL_DEVICE_TYPE_ACCELERATOR:
-            std::cout << "ACCELERATOR";
-            break;
-        case CL_DEVICE_TYPE_DEFAULT:
-            std::cout << "DEFAULT";
-            break;
-    }
-    std::cout << " || VENDOR_ID: " << dev.getInfo<CL_DEVICE_VENDOR_ID>();
-    std::cout << " || NAME: " << dev.getInfo<CL_DEVICE_NAME>();
-    std::cout << " || VENDOR: " << dev.getInfo<CL_DEVICE_VENDOR>();
-    std::cout << " || DRIVER_VERSION: " << dev.getInfo<CL_DRIVER_VERSION>();
-    std::cout << " || PROFILE: " << dev.getInfo<CL_DEVICE_PROFILE>();
-    std::cout << " || VERSION: " << dev.getInfo<CL_DEVICE_VERSION>();
-    std::cout << " || PLATFORM: " << dev.getInfo<CL_DEVICE_PLATFORM>();
-    std::cout << " || AVAILABLE: " << (dev.getInfo<CL_DEVICE_AVAILABLE>() ? "YES" : "NO");
-    std::cout << " || COMPILER_AVAILABLE: " << (dev.getInfo<CL_DEVICE_COMPILER_AVAILABLE>() ? "YES" : "NO");
-    std::cout << " || OPENCL_C_VERSION: " << dev.getInfo<CL_DEVICE_OPENCL_C_VERSION>();
-    std::cout << " || PARENT_DEVICE: ";
-    auto parent = dev.getInfo<CL_DEVICE_PARENT_DEVICE>();
-	std::cout << (parent.get() ? parent.get() : 0);
-    std::cout << " || ADDRESS_BITS: " << dev.getInfo<CL_DEVICE_ADDRESS_BITS>();
-    std::cout << " || MEM_BASE_ADDR_ALIGN: " << dev.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>();
-    std::cout << " || MIN_DATA_TYPE_ALIGN_SIZE: " << dev.getInfo<CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE>();
-    std::cout << " || CONSTANT_BUFFER_SIZE: " << dev.getInfo<CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE>();
-    std::cout << " || ERROR_CORRECTION_SUPPORT: " << (dev.getInfo<CL_DEVICE_ERROR_CORRECTION_SUPPORT>() ? "YES" : "NO");
-    std::cout << " || PROFILING_TIMER_RESOLUTION: " << dev.getInfo<CL_DEVICE_PROFILING_TIMER_RESOLUTION>();
-    std::cout << " || ENDIAN_LITTLE: " << (dev.getInfo<CL_DEVICE_ENDIAN_LITTLE>() ? "YES" : "NO");
-    std::cout << " || EXECUTION_CAPABILITIES: ";
-    switch(dev.getInfo<CL_DEVICE_EXECUTION_CAPABILITIES>())
-    {
-        case CL_EXEC_KERNEL:
-            std::cout << "KERNEL";
-            break;
-        case CL_EXEC_NATIVE_KERNEL:
-            std::cout << "NATIVE_KERNEL";
-            break;
-            
-    }
-    std::cout << " || QUEUE_PROPERTIES: ";
-    switch(dev.getInfo<CL_DEVICE_QUEUE_PROPERTIES>())
-    {
-        case CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE:
-            std::cout << "OUT_OF_ORDER_EXEC_MODE_ENABLE";
-            break;
-        case CL_QUEUE_PROFILING_ENABLE:
-            std::cout << "PROFILING_ENABLE";
-            break;
-    }
-    std::cout << " || HOST_UNIFIED_MEMORY: " << (dev.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() ? "YES" : "NO");
-    std::cout << " || BUILT_IN_KERNELS: " << dev.getInfo<CL_DEVICE_BUILT_IN_KERNELS>();
-    std::cout << " || REFERENCE_COUNT: " << dev.getInfo<CL_DEVICE_REFERENCE_COUNT>();
-    //std::cout << " || LINKER_AVAILABLE: " << (dev.getInfo<CL_DEVICE_LINKER_AVAILABLE>() ? "YES" : "NO");
-    //std::cout << " || PRINTF_BUFFER_SIZE: " << dev.getInfo<CL_DEVICE_PRINTF_BUFFER_SIZE>();
-    
-    std::cout << "\n= EXTENSIONS =\n" << dev.getInfo<CL_DEVICE_EXTENSIONS>();
-    
-    std::cout << "\n= NATIVE_VECTOR_WIDTH =\nCHAR: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_CHAR>();
-    std::cout << " || SHORT: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_SHORT>();
-    std::cout << " || INT: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_INT>();
-    std::cout << " || LONG: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_LONG>();
-    std::cout << " || FLOAT: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_FLOAT>();
-    std::cout << " || DOUBLE: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_DOUBLE>();
-    std::cout << " || HALF: " << dev.getInfo<CL_DEVICE_NATIVE_VECTOR_WIDTH_HALF>();
-    
-    std::cout << "\n= REFERRED_VECTOR_WIDTH =\nCHAR: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR>();
-    std::cout << " || SHORT: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT>();
-    std::cout << " || INT: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT>();
-    std::cout << " || LONG: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG>();
-    std::cout << " || FLOAT: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT>();
-    std::cout << " || DOUBLE: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE>();
-    std::cout << " || HALF: " << dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_HALF>();
-    
-    std::cout << "\nPREFERRED_INTEROP_USER_SYNC: " << dev.getInfo<CL_DEVICE_PREFERRED_INTEROP_USER_SYNC>();
-    
-    std::cout << "\n= MAX_WORK =\nITEM_DIMENSIONS: " << dev.getInfo<CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS>();
-    std::cout << " || GROUP_SIZE: " << dev.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
-    std::cout << " || ITEM_SIZES: ";
-    auto sizes = dev.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
-    for(auto s : sizes)
-    {
-        std::cout << s << ", ";
-    }
-    
-    std::cout << "\n= MAX =\nCOMPUTE_UNITS: " << dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
-    std::cout << " || CLOCK_FREQUENCY: " << dev.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>();
-    std::cout << " || READ_IMAGE_ARGS: " << dev.getInfo<CL_DEVICE_MAX_READ_IMAGE_ARGS>();
-    std::cout << " || WRITE_IMAGE_ARGS: " << dev.getInfo<CL_DEVICE_MAX_WRITE_IMAGE_ARGS>();
-    std::cout << " || MEM_ALLOC_SIZE: " << dev.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
-    std::cout << " || PARAMETER_SIZE: " << dev.getInfo<CL_DEVICE_MAX_PARAMETER_SIZE>();
-    std::cout << " || SAMPLERS: " << dev.getInfo<CL_DEVICE_MAX_SAMPLERS>();
-    std::cout << " || CONSTANT_ARGS: " << dev.getInfo<CL_DEVICE_MAX_CONSTANT_ARGS>();
-    
-    
-    std::cout << "\n= IMAGE =\nSUPPORT: " << (dev.getInfo<CL_DEVICE_IMAGE_SUPPORT>() ? "YES" : "NO");
-    //std::cout << " || MAX_BUFFER_SIZE: " << dev.getInfo<CL_DEVICE_IMAGE_MAX_BUFFER_SIZE>();
-    //std::cout << " || MAX_ARRAY_SIZE: " << dev.getInfo<CL_DEVICE_IMAGE_MAX_ARRAY_SIZE>();
-    //std::cout << " || PITCH_ALIGNMENT: " << dev.getInfo<CL_DEVICE_IMAGE_PITCH_ALIGNMENT>();
-    //std::cout << " || BASE_ADDRESS_ALIGNMENT: " << dev.getInfo<CL_DEVICE_IMAGE_BASE_ADDRESS_ALIGNMENT>();
-    std::cout << " || 2D_MAX_WIDTH: " << dev.getInfo<CL_DEVICE_IMAGE2D_MAX_WIDTH>();
-    std::cout << " || 2D_MAX_HEIGHT: " << dev.getInfo<CL_DEVICE_IMAGE2D_MAX_HEIGHT>();
-    std::cout << " || 3D_MAX_WIDTH: " << dev.getInfo<CL_DEVICE_IMAGE3D_MAX_WIDTH>();
-    std::cout << " || 3D_MAX_HEIGHT: " << dev.getInfo<CL_DEVICE_IMAGE3D_MAX_HEIGHT>();
-    std::cout << " || 3D_MAX_DEPTH: " << dev.getInfo<CL_DEVICE_IMAGE3D_MAX_DEPTH>();
-    
-    std::cout << "\n= LOCAL_MEM =\nTYPE: ";
-    switch(dev.getInfo<CL_DEVICE_LOCAL_MEM_TYPE>())
-    {
-        case CL_LOCAL:
-            std::cout << "LOCAL";
-            break;
-        case CL_GLOBAL:
-            std::cout << "GLOBAL";
-            break;
-    }
-    std::cout << " || SIZE: " << dev.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
-    
-    std::cout << "\n= GLOBAL_MEM =\nCACHE_TYPE: ";
-    switch(dev.getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_TYPE>())
-    {
-        case CL_NONE:
-            std::cout << "NONE";
-            break;
-        case CL_READ_ONLY_CACHE:
-            std::cout << "ONLY_CACHE";
-            break;
-        case CL_READ_WRITE_CACHE:
-            std::cout << "READ_WRITE_CACHE";
-            break;
-    }
-    std::cout << " || CACHELINE_SIZE: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE>();
-    std::cout << " || CACHE_SIZE: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_SIZE>();
-    std::cout << " || SIZE: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
-    
-    
-    std::cout << "\n= FP_CONFIG =\nSINGLE: ";
-	auto single_fp = dev.getInfo<CL_DEVICE_SINGLE_FP_CONFIG>();
-	if (single_fp & CL_FP_DENORM) std::cout << "DENORM" << "|";
-	if (single_fp & CL_FP_INF_NAN) std::cout << "INF_NAN" << "|";
-	if (single_fp & CL_FP_ROUND_TO_NEAREST) std::cout << "ROUND_TO_NEAREST" << "|";
-	if (single_fp & CL_FP_ROUND_TO_ZERO) std::cout << "ROUND_TO_ZERO" << "|";
-	if (single_fp & CL_FP_ROUND_TO_INF) std::cout << "ROUND_TO_INF" << "|";
-	if (single_fp & CL_FP_FMA) std::cout << "FMA" << "|";
-	if (single_fp & CL_FP_SOFT_FLOAT) std::cout << "SOFT_FLOAT" << "|";
-	if (single_fp & CL_FP_CORRECTLY_ROUNDED_DIVIDE_SQRT) std::cout << "CORRECTLY_ROUNDED_DIVIDE_SQRT" << "|";
-    std::cout << "\nDOUBLE: ";
-	auto double_fp = dev.getInfo<CL_DEVICE_DOUBLE_FP_CONFIG>();
-	if (double_fp & CL_FP_DENORM) std::cout << "DENORM" << "|";
-	if (double_fp & CL_FP_INF_NAN) std::cout << "INF_NAN" << "|";
-	if (double_fp & CL_FP_ROUND_TO_NEAREST) std::cout << "ROUND_TO_NEAREST" << "|";
-	if (double_fp & CL_FP_ROUND_TO_ZERO) std::cout << "ROUND_TO_ZERO" << "|";
-	if (double_fp & CL_FP_ROUND_TO_INF) std::cout << "ROUND_TO_INF" << "|";
-	if (double_fp & CL_FP_FMA) std::cout << "FMA" << "|";
-	if (double_fp & CL_FP_SOFT_FLOAT) std::cout << "SOFT_FLOAT" << "|";
-	if (double_fp & CL_FP_CORRECTLY_ROUNDED_DIVIDE_SQRT) std::cout << "CORRECTLY_ROUNDED_DIVIDE_SQRT" << "|";
-    
-	auto partition_affinity_domain = dev.getInfo<CL_DEVICE_PARTITION_AFFINITY_DOMAIN>();
-	if (partition_affinity_domain)
-	{
-		std::cout << "\n= PARTITION =\nAFFINITY_DOMAIN: ";
-		switch (partition_affinity_domain)
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> a = randomVector(n, 0.1, 10.0), b = randomVector(n, -10.0, 10.0, 1), c(n);
+	std::vector<long double> ref(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		ref[i] = std::pow(static_cast<long double>(a[i]), static_cast<long double>(b[i]));
+	}
+
+	const size_t bytes = n * sizeof(double);
+	const cl::CommandQueue& queue = rt.queue();
+	cl::Buffer A(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, a.data());
+	cl::Buffer B(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, b.data());
+	cl::Buffer C(rt.context(), CL_MEM_WRITE_ONLY, bytes);
+	const LaunchConfig launch = deviceCL_LaunchConfig(device);
+
+	std::cout << n << " elements, base in [0.1, 10), exponent in [-10, 10), " << toString(launch) << "\n";
+	std::cout << "mode      max ULP      mean ULP     wall ms      G elements/s\n";
+
+	const char* fastest = nullptr;
+	double fastestMs = 0.0;
+	for (MathMode mode : { MathMode::Strict, MathMode::Relaxed, MathMode::Native, MathMode::Half })
+	{
+		cl::Kernel kernel = powCL_Kernel(rt, launch, A, B, PowPath::General, mode);
+		// Warm up, then the median of a few runs
+		const double median = medianMs([&] { enqueueCL_Pow(queue, kernel, launch, n, A, B, C).wait(); }, 5);
+		queue.enqueueReadBuffer(C, CL_TRUE, 0, bytes, c.data());
+
+		double maxUlp = 0.0, sumUlp = 0.0;
+		for (size_t i = 0; i < n; ++i)
 		{
-		case CL_DEVICE_AFFINITY_DOMAIN_NUMA:
-			std::cout << "NUMA";
-			break;
-		case CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE:
-			std::cout << "L4_CACHE";
-			break;
-		case CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE:
-			std::cout << "L3_CACHE";
-			break;
-		case CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE:
-			std::cout << "L2_CACHE";
-			break;
-		case CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE:
-			std::cout << "L1_CACHE";
-			break;
-		case CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE:
-			std::cout << "NEXT_PARTITIONABLE";
-			break;
+			double err = ulpError(c[i], ref[i]);
+			maxUlp = std::max(maxUlp, err);
+			sumUlp += err;
 		}
-		//std::cout << " || MAX_SUB_DEVICES: " << dev.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>();
-		std::cout << " || PROPERTIES: ";
-		auto partition_properties = dev.getInfo<CL_DEVICE_PARTITION_PROPERTIES>();
-		for (auto pp : partition_properties)
+
+		std::cout << std::left << std::setw(10) << toString(mode) << std::setw(13) << maxUlp << std::setw(13)
+			<< sumUlp / n << std::setw(13) << median << n / median * 1e-6 << std::right << "\n";
+
+		if (maxUlp <= tolerance && (!fastest || median < fastestMs))
 		{
-			switch (pp)
+			fastest = toString(mode);
+			fastestMs = median;
+		}
+	}
+
+	if (fastest)
+		std::cout << "Fastest within " << tolerance << " ULP: " << fastest << "\n";
+	else
+		std::cout << "No mode is within " << tolerance << " ULP\n";
+}
+
+// End to end time, kernel time and error against a long double reference of each precision the
+// device supports: native fp64, float, and double-float
+void benchPrecisions(Runtime& rt, size_t n)
+{
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> a = randomVector(n, 0.1, 10.0), b = randomVector(n, -10.0, 10.0, 1), c(n);
+	std::vector<long double> ref(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		ref[i] = std::pow(static_cast<long double>(a[i]), static_cast<long double>(b[i]));
+	}
+
+	std::vector<Precision> precisions;
+	if (hasCL_DoublePrecision(device))
+		precisions.push_back(Precision::Double);
+	precisions.push_back(Precision::Float);
+	precisions.push_back(Precision::DoubleFloat);
+
+	std::cout << n << " elements on " << device.getInfo<CL_DEVICE_NAME>()
+		<< ", base in [0.1, 10), exponent in [-10, 10)\n";
+	std::cout << "precision     max ULP      mean ULP     total ms     kernel ms    G elements/s\n";
+	for (Precision precision : precisions)
+	{
+		// Warm up (program build), then the best of a few runs
+		double bestMs = 0.0, kernelMs = 0.0;
+		for (int r = 0; r < 4; ++r)
+		{
+			Profiler profiler;
+			Stopwatch sw;
+			if (precision == Precision::Double)
 			{
-			case CL_DEVICE_PARTITION_EQUALLY:
-				std::cout << "EQUALLY";
-				break;
-			case CL_DEVICE_PARTITION_BY_COUNTS:
-				std::cout << "BY_COUNTS";
-				break;
-			case CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN:
-				std::cout << "BY_AFFINITY_DOMAIN";
-				break;
+				const size_t bytes = n * sizeof(double);
+				cl::CommandQueue queue(rt.context(), device, CL_QUEUE_PROFILING_ENABLE);
+				cl::Buffer A(rt.context(), CL_MEM_READ_ONLY, bytes), B(rt.context(), CL_MEM_READ_ONLY, bytes);
+				cl::Buffer C(rt.context(), CL_MEM_WRITE_ONLY, bytes);
+				cl::Event writeA, writeB, read;
+				queue.enqueueWriteBuffer(A, CL_FALSE, 0, bytes, a.data(), nullptr, &writeA);
+				queue.enqueueWriteBuffer(B, CL_FALSE, 0, bytes, b.data(), nullptr, &writeB);
+				const LaunchConfig launch = deviceCL_LaunchConfig(device);
+				cl::Kernel kernel(rt.program(kernelTunable, launch.options()), "entry_point");
+				cl::Event computed = enqueueCL_Pow(queue, kernel, launch, n, A, B, C);
+				queue.enqueueReadBuffer(C, CL_TRUE, 0, bytes, c.data(), nullptr, &read);
+				profiler.record("entry_point", Profiler::Kernel, computed, n);
+			}
+			else
+				powCL_Reduced(rt, precision, a.data(), b.data(), 0.0, c.data(), n, &profiler);
+			const double ms = sw.elapsedMs();
+
+			if (r == 1 || (r > 1 && ms < bestMs))
+			{
+				bestMs = ms;
+				kernelMs = profiler.deviceMs(Profiler::Kernel);
 			}
-			std::cout << ", ";
 		}
-		std::cout << " || TYPE: ";
-		auto partition_type = dev.getInfo<CL_DEVICE_PARTITION_TYPE>();
-		for (auto pt : partition_type)
+
+		double maxUlp = 0.0, sumUlp = 0.0;
+		for (size_t i = 0; i < n; ++i)
 		{
-			std::cout << pt << ", ";
+			double err = ulpError(c[i], ref[i]);
+			maxUlp = std::max(maxUlp, err);
+			sumUlp += err;
 		}
+
+		std::cout << std::left << std::setw(14) << toString(precision) << std::setw(13) << maxUlp << std::setw(13)
+			<< sumUlp / n << std::setw(13) << bestMs << std::setw(13) << kernelMs << n / kernelMs * 1e-6
+			<< std::right << "\n";
 	}
-    std::cout << "\n+++++++++++++++++++++++++++++++++++++\n";
 }
 
-void printCL_Devices(const cl::Platform& platform)
+// Storage formats: end to end, transfer and kernel time with the largest relative error against
+// pow() of the unrounded inputs, then the host conversions portable against SIMD
+void benchStorage(Runtime& rt, size_t n)
 {
-	std::vector<cl::Device> devices;
-	platform.getDevices(CL_DEVICE_TYPE_GPU, &devices);
-	for (auto d : devices)
-		printCL_DeviceInfo(d);
-	std::cout << std::endl;
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+	const bool computeDouble = hasCL_DoublePrecision(device);
+
+	// Results within [1/16, 16], well inside the range of half
+	std::vector<double> a = randomVector(n, 0.5, 2.0), b = randomVector(n, -4.0, 4.0, 1), c(n), ref(n);
+	for (size_t i = 0; i < n; ++i)
+		ref[i] = std::pow(a[i], b[i]);
+
+	std::vector<Storage> storages;
+	if (computeDouble)
+		storages.push_back(Storage::Double);
+	storages.push_back(Storage::Float);
+	storages.push_back(Storage::Half);
+
+	std::cout << n << " elements on " << device.getInfo<CL_DEVICE_NAME>() << ", computed in "
+		<< (computeDouble ? "double" : "float") << "\n";
+	std::cout << "storage   bytes     max rel err  total ms     transfer ms  kernel ms\n";
+	for (Storage storage : storages)
+	{
+		// Warm up (program build), then the best of a few runs
+		double bestMs = 0.0, transferMs = 0.0, kernelMs = 0.0;
+		for (int r = 0; r < 4; ++r)
+		{
+			Profiler profiler;
+			Stopwatch sw;
+			powCL_Packed(rt, storage, computeDouble, a.data(), b.data(), 0.0, c.data(), n, &profiler);
+			const double ms = sw.elapsedMs();
+
+			if (r == 1 || (r > 1 && ms < bestMs))
+			{
+				bestMs = ms;
+				transferMs = profiler.deviceMs(Profiler::Write) + profiler.deviceMs(Profiler::Read);
+				kernelMs = profiler.deviceMs(Profiler::Kernel);
+			}
+		}
+
+		double maxErr = 0.0;
+		for (size_t i = 0; i < n; ++i)
+			maxErr = std::max(maxErr, std::fabs(c[i] - ref[i]) / ref[i]);
+
+		std::cout << std::left << std::setw(10) << toString(storage) << std::setw(10) << 3 * n * storageSize(storage)
+			<< std::setw(13) << maxErr << std::setw(13) << bestMs << std::setw(13) << transferMs << kernelMs
+			<< std::right << "\n";
+	}
+
+	std::vector<float> f(n);
+	std::vector<uint16_t> h(n);
+	auto rate = [&](const std::function<void(bool)>& convert, bool simd) {
+		convert(simd);
+		Stopwatch sw;
+		for (int r = 0; r < 3; ++r)
+			convert(simd);
+		return 3 * n / sw.elapsedMs() * 1e-6;
+	};
+	const std::vector<std::pair<const char*, std::function<void(bool)>>> conversions{
+		{ "double -> float", [&](bool simd) { convertToFloat(a.data(), f.data(), n, simd); } },
+		{ "float -> double", [&](bool simd) { convertFromFloat(f.data(), c.data(), n, simd); } },
+		{ "double -> half", [&](bool simd) { convertToHalf(a.data(), h.data(), n, simd); } },
+		{ "half -> double", [&](bool simd) { convertFromHalf(h.data(), c.data(), n, simd); } },
+	};
+	std::cout << "\nHost conversions, G elements/s" << (hasHostF16C() ? "" : " (no F16C, SIMD falls back)") << "\n";
+	std::cout << "conversion        portable     SIMD\n";
+	for (const auto& conversion : conversions)
+	{
+		std::cout << std::left << std::setw(18) << conversion.first << std::setw(13) << rate(conversion.second, false)
+			<< rate(conversion.second, true) << std::right << "\n";
+	}
+}
+
+// r = sqrt(pow(a, b) + c) as one fused kernel against one kernel per operation with the
+// intermediate values in global memory
+void benchFusion(Runtime& rt, size_t n)
+{
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> a = randomVector(n, 0.0, 10.0), b = randomVector(n, -4.0, 4.0, 1),
+		c = randomVector(n, 0.0, 10.0, 2);
+
+	ocl::DeviceVector<double> A(rt, a), B(rt, b), C(rt, c), T(rt, n), R(rt, n);
+	auto fused = [&] { R = sqrt(pow(A, B) + C); };
+	auto stepwise = [&] {
+		T = pow(A, B);
+		T = T + C;
+		R = sqrt(T);
+	};
+
+	std::cout << n << " elements on " << device.getInfo<CL_DEVICE_NAME>() << ", r = sqrt(pow(a, b) + c)\n";
+	// Vectors read and written per element
+	struct Variant
+	{
+		const char* name;
+		std::function<void()> run;
+		unsigned vectorsMoved;
+	};
+	const Variant variants[] = { { "fused   ", fused, 4 }, { "stepwise", stepwise, 8 } };
+	std::vector<double> results[2];
+	for (int k = 0; k < 2; ++k)
+	{
+		// Warm up (program builds), then the median of a few runs
+		const double median = medianMs([&] {
+			variants[k].run();
+			rt.queue().finish();
+		}, 5);
+		results[k] = R.toHost();
+
+		const size_t bytes = variants[k].vectorsMoved * n * sizeof(double);
+		std::cout << variants[k].name << ": " << median << " ms, " << bytes / median * 1e-6 << " GB/s of "
+			<< bytes / (1 << 20) << " MiB moved\n";
+	}
+
+	uint64_t maxUlp = 0;
+	for (size_t i = 0; i < n; ++i)
+		maxUlp = std::max(maxUlp, ulpDistance(results[0][i], results[1][i]));
+	std::cout << "max " << maxUlp << " ULP between them\n";
 }
 
-cl::Platform getCL_Platform()
+// Sum, min, max and argmin of a device resident vector against the same reductions on the host
+// over every hardware thread, and against reading the vector back
+void benchReductions(Runtime& rt, size_t n)
 {
-	std::vector<cl::Platform> platforms;
-	cl::Platform::get(&platforms);
-	size_t cur_platform = platforms.size();
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> data = randomVector(n, -1.0, 1.0);
+	ocl::DeviceVector<double> v(rt, data);
+	v.syncToDevice();
+
+	std::cout << n << " elements on " << device.getInfo<CL_DEVICE_NAME>() << ", tuned "
+		<< toString(getCL_ReduceConfig(rt)) << "\n";
+
+	// Host reduction of [first, last) for each op: the value, and the index for argmin
+	auto hostReduce = [&data](ReduceOp op, size_t first, size_t last) {
+		const auto begin = data.begin() + first, end = data.begin() + last;
+		switch (op)
+		{
+		case ReduceOp::Sum:
+			return std::make_pair(std::accumulate(begin, end, 0.0), size_t(0));
+		case ReduceOp::Min:
+			return std::make_pair(*std::min_element(begin, end), size_t(0));
+		case ReduceOp::Max:
+			return std::make_pair(*std::max_element(begin, end), size_t(0));
+		default:
+			const auto it = std::min_element(begin, end);
+			return std::make_pair(*it, static_cast<size_t>(it - data.begin()));
+		}
+	};
+	// No more chunks than elements, min and max have no value for an empty one
+	const unsigned threads = static_cast<unsigned>(
+		std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), n));
+	auto hostParallel = [&](ReduceOp op) {
+		std::vector<std::future<std::pair<double, size_t>>> parts;
+		for (unsigned t = 0; t < threads; ++t)
+			parts.push_back(std::async(std::launch::async, hostReduce, op, n * t / threads, n * (t + 1) / threads));
+		std::pair<double, size_t> result = parts[0].get();
+		for (unsigned t = 1; t < threads; ++t)
+		{
+			const std::pair<double, size_t> part = parts[t].get();
+			if (op == ReduceOp::Sum)
+				result.first += part.first;
+			else if (op == ReduceOp::Max ? part.first > result.first : part.first < result.first)
+				result = part;
+		}
+		return result;
+	};
+
+	std::cout << "op      device ms    host ms      device result           host result\n";
+	for (ReduceOp op : { ReduceOp::Sum, ReduceOp::Min, ReduceOp::Max, ReduceOp::ArgMin })
+	{
+		std::pair<double, size_t> device, host;
+		const double deviceMs = medianMs([&] {
+			if (op == ReduceOp::ArgMin)
+				device.second = ocl::argmin(v);
+			else
+				device.first = ocl::reduce(v, op);
+		}, 5);
+		const double hostMs = medianMs([&] { host = hostParallel(op); }, 5);
+
+		std::cout << std::left << std::setw(8) << toString(op) << std::setw(13) << deviceMs << std::setw(13) << hostMs
+			<< std::setprecision(17) << std::setw(24);
+		if (op == ReduceOp::ArgMin)
+			std::cout << device.second << host.second;
+		else
+			std::cout << device.first << host.first;
+		std::cout << std::setprecision(6) << std::right << "\n";
+	}
 
-	if (!cur_platform)
+	const size_t segments = 64;
+	std::vector<double> sums;
+	const double segmentedMs = medianMs([&] { sums = ocl::reduce(v, ReduceOp::Sum, segments); }, 5);
+	double maxDiff = 0.0;
+	const size_t segment = (n + segments - 1) / segments;
+	for (size_t s = 0; s < segments; ++s)
 	{
-		throw std::domain_error("OpenCL platforms aren't found.");
+		const size_t first = std::min(n, s * segment), last = std::min(n, first + segment);
+		maxDiff = std::max(maxDiff, std::fabs(sums[s] - hostReduce(ReduceOp::Sum, first, last).first));
 	}
+	std::cout << segments << " segment sums: " << segmentedMs << " ms, max difference from the host " << maxDiff << "\n";
+
+	std::vector<double> back(n);
+	const double readMs = medianMs([&] {
+		rt.queue().enqueueReadBuffer(v.buffer(), CL_TRUE, 0, n * sizeof(double), back.data());
+	}, 5);
+	std::cout << "Reading the vector back instead: " << readMs << " ms\n";
+}
 
-	for (size_t p = 0; p < platforms.size(); ++p)
+// Post-filtering pow results: compaction on the device, reading back the survivors only,
+// against reading everything back and filtering on the host. Then a prefix sum against
+// std::partial_sum.
+void benchCompaction(Runtime& rt, size_t n)
+{
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	// Negative bases make NaN for most exponents, large ones overflow
+	std::vector<double> a = randomVector(n, -1.0, 10.0), b = randomVector(n, -20.0, 400.0, 1);
+	ocl::DeviceVector<double> A(rt, std::move(a)), B(rt, std::move(b)), C(rt, n);
+	C = pow(A, B);
+
+	std::cout << n << " elements on " << device.getInfo<CL_DEVICE_NAME>() << ", c = pow(a, b)\n";
+	std::cout << "keep              kept %       device ms    host ms      same\n";
+	std::vector<double> all(n);
+	for (double threshold : { 0.0, 1.0, 1e100, 1e300 })
 	{
-		printCL_PlatformInfo(platforms.at(p));
-		std::string ver;
-		if (platforms.at(p).getInfo(CL_PLATFORM_VERSION, &ver) == CL_SUCCESS)
+		CompactFilter filter;
+		filter.above = threshold > 0.0;
+		filter.threshold = threshold;
+
+		std::vector<double> kept, expected;
+		const double deviceMs = medianMs([&] { kept = ocl::compact(C, filter); }, 5);
+		const double hostMs = medianMs([&] {
+			rt.queue().enqueueReadBuffer(C.buffer(), CL_TRUE, 0, n * sizeof(double), all.data());
+			expected.clear();
+			for (double x : all)
+			{
+				if (std::isfinite(x) && (!filter.above || x > threshold))
+					expected.push_back(x);
+			}
+		}, 5);
+
+		std::ostringstream keep;
+		keep << "finite" << (filter.above ? " > " : "");
+		if (filter.above)
+			keep << threshold;
+		std::cout << std::left << std::setw(18) << keep.str() << std::setw(13) << 100.0 * kept.size() / n
+			<< std::setw(13) << deviceMs << std::setw(13) << hostMs << (kept == expected ? "yes" : "NO") << std::right
+			<< "\n";
+	}
+
+	std::vector<uint32_t> counts(n);
+	std::mt19937_64 rng(n);
+	for (uint32_t& x : counts)
+		x = static_cast<uint32_t>(rng() % 10);
+	std::vector<uint32_t> expected(n);
+	const double hostMs = medianMs([&] { std::partial_sum(counts.begin(), counts.end(), expected.begin()); }, 5);
+	ocl::DeviceVector<uint32_t> in(rt, std::move(counts)), out(rt, n);
+	in.syncToDevice();
+	const double deviceMs = medianMs([&] {
+		ocl::inclusiveScan(in, out);
+		rt.queue().finish();
+	}, 5);
+	std::cout << "Inclusive scan of " << n << " uints: " << deviceMs << " ms on the device, " << hostMs
+		<< " ms with std::partial_sum, " << (out.host() == expected ? "same" : "DIFFERENT") << " results\n";
+}
+
+// Sort on the device against std::sort and a parallel host sort (std::sort of one chunk per
+// hardware thread, then rounds of pairwise merges), then keys with their indices as payload
+void benchSort(Runtime& rt, size_t n)
+{
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	std::vector<double> data = randomVector(n, 0.0, 10.0);
+	const std::vector<double> exponents = randomVector(n, -20.0, 20.0, 1);
+	for (size_t i = 0; i < n; ++i)
+		data[i] = std::pow(data[i], exponents[i]);
+	const size_t bytes = n * sizeof(double);
+	cl::Buffer unsorted(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, data.data());
+
+	// Every run starts from the unsorted data, the copy is not timed
+	ocl::DeviceVector<double> keys(rt, n);
+	const double deviceMs = medianMs(
+		[&] {
+			ocl::sort(keys);
+			rt.queue().finish();
+		}, 3,
+		[&] {
+			rt.queue().enqueueCopyBuffer(unsorted, keys.bufferForWriting(), 0, 0, bytes);
+			rt.queue().finish();
+		});
+
+	std::vector<double> expected;
+	const double hostMs = medianMs([&] { std::sort(expected.begin(), expected.end()); }, 3, [&] { expected = data; });
+
+	const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<double> parallel;
+	const double parallelMs = medianMs([&] {
+		std::vector<size_t> bounds;
+		for (unsigned t = 0; t <= threads; ++t)
+			bounds.push_back(n * t / threads);
+		std::vector<std::future<void>> tasks;
+		for (unsigned t = 0; t < threads; ++t)
+		{
+			tasks.push_back(std::async(std::launch::async, [&parallel, &bounds, t] {
+				std::sort(parallel.begin() + bounds[t], parallel.begin() + bounds[t + 1]);
+			}));
+		}
+		for (auto& task : tasks)
+			task.get();
+		for (size_t width = 1; width < threads; width *= 2)
 		{
-			if (getCL_ver(ver) == v120)
+			tasks.clear();
+			for (size_t t = 0; t + width < threads; t += 2 * width)
 			{
-				cur_platform = p;
-				printCL_Devices(platforms.at(p));
+				const size_t first = bounds[t], middle = bounds[t + width], last = bounds[std::min<size_t>(t + 2 * width, threads)];
+				tasks.push_back(std::async(std::launch::async, [&parallel, first, middle, last] {
+					std::inplace_merge(parallel.begin() + first, parallel.begin() + middle, parallel.begin() + last);
+				}));
 			}
+			for (auto& task : tasks)
+				task.get();
 		}
+	}, 3, [&] { parallel = data; });
+
+	// Percentiles straight from the sorted device copy, two elements read back
+	const size_t p50 = (n - 1) / 2, p95 = (n - 1) * 95 / 100;
+	const double at50 = keys.get(p50), at95 = keys.get(p95);
+
+	std::cout << n << " doubles on " << device.getInfo<CL_DEVICE_NAME>() << "\n";
+	std::cout << "radix sort on the device: " << deviceMs << " ms, " << (keys.host() == expected ? "same" : "DIFFERENT")
+		<< " order as std::sort, median " << at50 << ", p95 " << at95 << "\n";
+	std::cout << "std::sort:                " << hostMs << " ms\n";
+	std::cout << "parallel host sort:       " << parallelMs << " ms on " << threads << " threads, "
+		<< (parallel == expected ? "same" : "DIFFERENT") << " order\n";
+
+	// The indices as payload give the permutation
+	std::vector<uint32_t> iota(n);
+	std::iota(iota.begin(), iota.end(), 0u);
+	cl::Buffer unsortedIndices(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, n * sizeof(uint32_t), iota.data());
+	ocl::DeviceVector<uint32_t> indices(rt, n);
+	const double pairsMs = medianMs(
+		[&] {
+			ocl::sortByKey(keys, indices);
+			rt.queue().finish();
+		}, 3,
+		[&] {
+			rt.queue().enqueueCopyBuffer(unsorted, keys.bufferForWriting(), 0, 0, bytes);
+			rt.queue().enqueueCopyBuffer(unsortedIndices, indices.bufferForWriting(), 0, 0, n * sizeof(uint32_t));
+			rt.queue().finish();
+		});
+
+	bool permuted = true;
+	const std::vector<double>& sorted = keys.host();
+	const std::vector<uint32_t>& from = indices.host();
+	for (size_t i = 0; i < n && permuted; ++i)
+		permuted = data[from[i]] == sorted[i];
+	std::cout << "keys with uint indices:   " << pairsMs << " ms, " << (permuted ? "consistent" : "INCONSISTENT")
+		<< " permutation\n";
+
+	// Special values in the order radix_sort.h gives, a NaN with the sign bit set (x86's 0/0)
+	// included, which std::sort can't take
+	const double inf = std::numeric_limits<double>::infinity();
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	ocl::DeviceVector<double> specials(rt, std::vector<double>{ nan, 1.0, -inf, std::copysign(nan, -1.0), 0.0, inf,
+		-0.0, -1.0 });
+	ocl::sort(specials);
+	const std::vector<double>& s = specials.host();
+	const bool ordered = s[0] == -inf && s[1] == -1.0 && s[2] == 0.0 && std::signbit(s[2]) && s[3] == 0.0
+		&& !std::signbit(s[3]) && s[4] == 1.0 && s[5] == inf && std::isnan(s[6]) && std::isnan(s[7]);
+	std::cout << "-inf, -1, -0, +0, 1, +inf, NaN, -NaN: " << (ordered ? "NaNs last" : "WRONG ORDER") << "\n";
+}
+
+// Inputs and output of the single pass made ready: host vectors filled and uploaded, as the
+// single pass did before, against fills on the device without host copies. The device way
+// runs first since the peak RSS only grows.
+void benchInit(Runtime& rt, size_t n)
+{
+	const cl::Device& device = rt.device();
+	n = clampToAlloc(device, n);
+
+	// The first command on the queue pays for starting it
+	{
+		ocl::DeviceVector<double> warm(rt, 1);
+		warm.fill(0.0).wait();
 	}
 
-	if (cur_platform == platforms.size())
+	double rss = peakRSS_MiB();
+	Stopwatch sw;
+	double deviceMs = 0.0, deviceRSS = 0.0;
+	uint64_t maxUlp = 0;
 	{
-		throw std::domain_error("OpenCL 1.2 platform is not found.");
+		ocl::DeviceVector<double> A(rt, n, CL_MEM_READ_ONLY), C(rt, n, CL_MEM_WRITE_ONLY);
+		A.fill(0.1).wait();
+		deviceMs = sw.elapsedMs();
+		deviceRSS = peakRSS_MiB() - rss;
+		maxUlp = ocl::validate(A, 0.1).maxUlp();
 	}
 
-	return std::move(platforms.at(cur_platform));
-}
+	// Patterns of 4 elements (32 bytes) go to clEnqueueFillBuffer, those of 3 are copied
+	const double pattern[] = { 0.1, 0.2, 0.3, 0.4 };
+	auto timePattern = [&](size_t count, bool& ok) {
+		ocl::DeviceVector<double> P(rt, n, CL_MEM_READ_ONLY);
+		Stopwatch psw;
+		P.fill(pattern, count).wait();
+		const double ms = psw.elapsedMs();
+		ok = true;
+		for (size_t i : { size_t(0), n / 2, n - 1 })
+			ok = ok && P.get(i) == pattern[i % count];
+		return ms;
+	};
+	bool ok4 = false, ok3 = false;
+	const double pattern4Ms = timePattern(4, ok4), pattern3Ms = timePattern(3, ok3);
 
-cl::Device getCL_Device()
-{
-	cl::Platform platform = getCL_Platform();
+	rss = peakRSS_MiB();
+	sw.restart();
+	double hostMs = 0.0, hostRSS = 0.0;
+	{
+		std::vector<double> a(n, 0.1), c(n);
+		ocl::DeviceVector<double> A(rt, std::move(a));
+		A.syncToDevice().wait();
+		hostMs = sw.elapsedMs();
+		hostRSS = peakRSS_MiB() - rss;
+	}
 
-	std::vector<cl::Device> devices;
+	std::cout << n << " doubles (" << n * sizeof(double) / (1024.0 * 1024.0) << " MiB) per operand on "
+		<< device.getInfo<CL_DEVICE_NAME>() << "\n";
+	std::cout << "fill on the device, no host copy: " << deviceMs << " ms, peak RSS +" << deviceRSS << " MiB, "
+		<< (maxUlp ? "WRONG" : "exact") << " (checked on the device)\n";
+	std::cout << "pattern of 4 elements:            " << pattern4Ms << " ms, " << (ok4 ? "ok" : "WRONG") << "\n";
+	std::cout << "pattern of 3 elements (copies):   " << pattern3Ms << " ms, " << (ok3 ? "ok" : "WRONG") << "\n";
+	std::cout << "host fill and upload:             " << hostMs << " ms, peak RSS +" << hostRSS << " MiB\n";
+}
 
-	platform.getDevices(CL_DEVICE_TYPE_GPU, &devices);
-	size_t cur_device = devices.size();
+// Host engine on every instruction set this machine has, against kernel1 on an OpenCL CPU device
+void benchHostEngine(size_t n)
+{
+	std::vector<double> a = randomVector(n, 0.0, 10.0), b = randomVector(n, -20.0, 20.0, 1), c(n), ref(n);
+	for (size_t i = 0; i < n; ++i)
+		ref[i] = std::pow(a[i], b[i]);
 
-    for (size_t d = 0; d < devices.size(); ++d) {
-		if (!devices[d].getInfo<CL_DEVICE_AVAILABLE>()) continue;
+	std::vector<std::unique_ptr<PowEngine>> engines;
+	engines.push_back(createHostPowEngine(HostSimd::Scalar));
+	HostSimd best = detectHostSimd();
+	if (best != HostSimd::Scalar)
+		engines.push_back(createHostPowEngine(HostSimd::Avx2));
+	if (best == HostSimd::Avx512)
+		engines.push_back(createHostPowEngine(HostSimd::Avx512));
 
-		std::string ext = devices[d].getInfo<CL_DEVICE_EXTENSIONS>();
+	try {
+		std::vector<cl::Platform> platforms;
+		cl::Platform::get(&platforms);
+		for (auto& p : platforms)
+		{
+			std::vector<cl::Device> devices;
+			p.getDevices(CL_DEVICE_TYPE_CPU, &devices);
+			for (auto& d : devices)
+			{
+				if (d.getInfo<CL_DEVICE_AVAILABLE>() && hasCL_DoublePrecision(d))
+					engines.push_back(createCL_PowEngine(d));
+			}
+		}
+	}
+	catch (const cl::Error& err) {
+		std::cout << "No OpenCL CPU device: " << err.what() << "(" << err.err() << ")\n";
+	}
 
-		// Get first available GPU device which supports double precision
-		if (cur_device == devices.size() && (ext.find("cl_khr_fp64") == std::string::npos || ext.find("cl_amd_fp64") == std::string::npos))
+	std::cout << n << " elements, base in [0, 10), exponent in [-20, 20)\n";
+	for (auto& engine : engines)
+	{
+		// Warm up, then keep the best of a few runs
+		engine->pow(a.data(), b.data(), c.data(), n);
+		double best_ms = 0.0;
+		for (int r = 0; r < 3; ++r)
 		{
-			cur_device = d;
-			break;
+			Stopwatch sw;
+			engine->pow(a.data(), b.data(), c.data(), n);
+			double ms = sw.elapsedMs();
+			best_ms = (r == 0 || ms < best_ms) ? ms : best_ms;
 		}
+
+		uint64_t maxUlp = 0;
+		for (size_t i = 0; i < n; ++i)
+			maxUlp = std::max(maxUlp, ulpDistance(c[i], ref[i]));
+
+		std::cout << engine->name() << ": " << best_ms << " ms, " << n / best_ms * 1e-3 << " M/s, max "
+			<< maxUlp << " ULP from std::pow\n";
 	}
+}
+
+struct Options
+{
+	size_t n{ N };
+	bool info{ false };
+	bool benchCache{ false };
+	int benchRuntime{ 0 };
+	bool stream{ false };
+	bool zeroCopy{ false };
+	bool multiDevice{ false };
+	unsigned subDevices{ 0 };
+	bool workStealing{ false };
+	bool host{ false };
+	HostSimd hostSimd{ detectHostSimd() };
+	bool benchHost{ false };
+	size_t tile{ size_t(1) << 18 };
+	size_t chunk{ size_t(1) << 20 };
+	unsigned depth{ 3 };
+	std::string profile; // Chrome trace output, empty when not profiling
+	bool tune{ true };
+	bool benchVector{ false };
+	bool benchIntPow{ false };
+	MathMode math{ MathMode::Strict };
+	bool benchMath{ false };
+	double tolerance{ 1.0 };
+	Precision precision{ Precision::Double };
+	bool precisionSet{ false };
+	bool benchPrecision{ false };
+	Storage storage{ Storage::Double };
+	bool benchStorage{ false };
+	bool benchFusion{ false };
+	bool benchReduce{ false };
+	bool benchCompact{ false };
+	bool benchSort{ false };
+	bool benchInit{ false };
+	bool random{ false };  // bases from the Philox sequence of 'seed' rather than 0.1
+	uint64_t seed{ 0 };
+	bool retune{ false };
+};
 
-	if (cur_device == devices.size())
+const char* USAGE =
+	"Usage: ex_01 [--size <elements>] [--stream [--chunk <elements>] [--depth <buffer sets>]]\n"
+	"             [--zero-copy] [--multi-device | --work-stealing [--tile <elements>]]\n"
+	"             [--sub-devices <count>] [--host [--host-simd scalar|avx2|avx512]] [--info]\n"
+	"             [--bench-cache] [--bench-runtime <jobs>] [--bench-host] [--profile <trace.json>]\n"
+	"             [--no-tune | --retune] [--bench-vector] [--bench-int-pow]\n"
+	"             [--math strict|relaxed|native|half] [--bench-math [--tolerance <ULP>]]\n"
+	"             [--precision double|float|double-float] [--bench-precision]\n"
+	"             [--storage double|float|half] [--bench-storage] [--bench-fusion]\n"
+	"             [--bench-reduce] [--bench-compact] [--bench-sort] [--bench-init] [--random <seed>]\n"
+	"--profile traces every device command of a run; --host has none, the --bench-* runs aren't traced";
+
+Options parseOptions(int argc, char* argv[])
+{
+	Options opt;
+	for (int i = 1; i < argc; ++i)
 	{
-		throw std::domain_error("GPUs with double precision not found.");
+		std::string arg = argv[i];
+		auto value = [&]() -> unsigned long long {
+			if (i + 1 >= argc)
+				throw std::invalid_argument(arg + " needs a value\n" + USAGE);
+			return std::stoull(argv[++i], nullptr, 0);
+		};
+		auto text = [&]() -> std::string {
+			if (i + 1 >= argc)
+				throw std::invalid_argument(arg + " needs a value\n" + USAGE);
+			return argv[++i];
+		};
+
+		if (arg == "--size")
+			opt.n = static_cast<size_t>(value());
+		else if (arg == "--info")
+			opt.info = true;
+		else if (arg == "--bench-runtime")
+			opt.benchRuntime = static_cast<int>(value());
+		else if (arg == "--bench-cache")
+			opt.benchCache = true;
+		else if (arg == "--stream")
+			opt.stream = true;
+		else if (arg == "--multi-device")
+			opt.multiDevice = true;
+		else if (arg == "--work-stealing")
+			opt.workStealing = true;
+		else if (arg == "--tile")
+			opt.tile = static_cast<size_t>(value());
+		else if (arg == "--sub-devices")
+			opt.subDevices = static_cast<unsigned>(value());
+		else if (arg == "--host")
+			opt.host = true;
+		else if (arg == "--host-simd")
+		{
+			std::string isa = text();
+			if (isa == "scalar")
+				opt.hostSimd = HostSimd::Scalar;
+			else if (isa == "avx2")
+				opt.hostSimd = HostSimd::Avx2;
+			else if (isa == "avx512")
+				opt.hostSimd = HostSimd::Avx512;
+			else
+				throw std::invalid_argument("Unknown instruction set " + isa + "\n" + USAGE);
+			opt.host = true;
+		}
+		else if (arg == "--bench-host")
+			opt.benchHost = true;
+		else if (arg == "--zero-copy")
+			opt.zeroCopy = true;
+		else if (arg == "--chunk")
+			opt.chunk = static_cast<size_t>(value());
+		else if (arg == "--depth")
+			opt.depth = static_cast<unsigned>(value());
+		else if (arg == "--profile")
+			opt.profile = text();
+		else if (arg == "--no-tune")
+			opt.tune = false;
+		else if (arg == "--retune")
+			opt.retune = true;
+		else if (arg == "--bench-vector")
+			opt.benchVector = true;
+		else if (arg == "--bench-int-pow")
+			opt.benchIntPow = true;
+		else if (arg == "--math")
+		{
+			std::string mode = text();
+			if (mode == "strict")
+				opt.math = MathMode::Strict;
+			else if (mode == "relaxed")
+				opt.math = MathMode::Relaxed;
+			else if (mode == "native")
+				opt.math = MathMode::Native;
+			else if (mode == "half")
+				opt.math = MathMode::Half;
+			else
+				throw std::invalid_argument("Unknown math mode " + mode + "\n" + USAGE);
+		}
+		else if (arg == "--bench-math")
+			opt.benchMath = true;
+		else if (arg == "--tolerance")
+			opt.tolerance = std::stod(text());
+		else if (arg == "--precision")
+		{
+			std::string precision = text();
+			if (precision == "double")
+				opt.precision = Precision::Double;
+			else if (precision == "float")
+				opt.precision = Precision::Float;
+			else if (precision == "double-float")
+				opt.precision = Precision::DoubleFloat;
+			else
+				throw std::invalid_argument("Unknown precision " + precision + "\n" + USAGE);
+			opt.precisionSet = true;
+		}
+		else if (arg == "--bench-precision")
+			opt.benchPrecision = true;
+		else if (arg == "--storage")
+		{
+			std::string storage = text();
+			if (storage == "double")
+				opt.storage = Storage::Double;
+			else if (storage == "float")
+				opt.storage = Storage::Float;
+			else if (storage == "half")
+				opt.storage = Storage::Half;
+			else
+				throw std::invalid_argument("Unknown storage " + storage + "\n" + USAGE);
+		}
+		else if (arg == "--bench-storage")
+			opt.benchStorage = true;
+		else if (arg == "--bench-fusion")
+			opt.benchFusion = true;
+		else if (arg == "--bench-reduce")
+			opt.benchReduce = true;
+		else if (arg == "--bench-compact")
+			opt.benchCompact = true;
+		else if (arg == "--bench-sort")
+			opt.benchSort = true;
+		else if (arg == "--bench-init")
+			opt.benchInit = true;
+		else if (arg == "--random")
+		{
+			opt.random = true;
+			opt.seed = value();
+		}
+		else
+			throw std::invalid_argument("Unknown option " + arg + "\n" + USAGE);
 	}
-    
-	return std::move(devices.at(cur_device));
+	if (!opt.n)
+		throw std::invalid_argument("Size must be positive");
+	return opt;
 }
 
-int main()
+int main(int argc, char* argv[])
 try
-{	
-	// Get a CL device
-	cl::Device device = getCL_Device();
+{
+	const Options opt = parseOptions(argc, argv);
+	const size_t n = opt.n;
 
-	// Get a CL context
-	cl::Context context = cl::Context(device);
+	// With --random the bases span the range the pow paths are timed on; the device generates
+	// them in place, the host the same values where it needs them
+	RandomSpec bases;
+	bases.a = 0.1;
+	bases.b = 10.0;
 
-	// Create a command queue
-	cl::CommandQueue queue(context, device);
+	if (opt.info)
+		getCL_Device(true);
 
-	// Compile OpenCL program for found device
-	cl::Program program(context,
-		cl::Program::Sources(1, std::make_pair(kernel1.c_str(), kernel1.size())));
+	if (opt.benchHost)
+	{
+		benchHostEngine(n);
+		return 0;
+	}
 
-	try {
-		program.build(std::vector<cl::Device>{ device });
+	if (opt.benchRuntime > 0)
+	{
+		benchRuntime(opt.benchRuntime);
+		return 0;
 	}
-	catch (const cl::Error& e) {
-		std::cerr << "CL program compilation error\n" << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device)
-			<< "\n/////////////////////////////////////\n" << kernel1
-			<< "\n/////////////////////////////////////\n";
-		throw e;
+
+	if (opt.multiDevice)
+	{
+		MultiDeviceExecutor executor(getCL_ComputeDevices(getCL_ComputePlatform(), opt.subDevices));
+		std::vector<double> a(n, 0.1), b(n, 3.0), c(n);
+		if (opt.random)
+			randomHost(bases, opt.seed, 0, n, a.data());
+		Profiler profiler;
+		Profiler* prof = opt.profile.empty() ? nullptr : &profiler;
+
+		// The first pass splits by peak rate, the following ones by measured throughput
+		for (int pass = 0; pass < 3; ++pass)
+		{
+			Stopwatch sw;
+			executor.run(a.data(), b.data(), c.data(), n, prof);
+			std::cout << "Pass " << pass << " on " << executor.deviceCount() << " devices: "
+				<< sw.elapsedMs() << " ms\n";
+			executor.printStats(std::cout);
+		}
+		if (prof)
+		{
+			prof->printSummary(std::cout);
+			prof->writeChromeTrace(opt.profile);
+		}
+
+		// Check result from a random place, must be 0.001 without --random
+		srand(time(NULL));
+		std::cout << c[rand() % n] << std::endl;
+		return 0;
 	}
 
-	// Create a kernel with the entry function "entry_point"
-	cl::Kernel k1(program, "entry_point");
+	if (opt.workStealing)
+	{
+		WorkStealingScheduler scheduler(getCL_ComputeDevices(getCL_ComputePlatform(), opt.subDevices));
+		std::vector<double> a(n, 0.1), b(n, 3.0), c(n);
+		if (opt.random)
+			randomHost(bases, opt.seed, 0, n, a.data());
+		Profiler profiler;
+		Profiler* prof = opt.profile.empty() ? nullptr : &profiler;
+
+		Stopwatch sw;
+		scheduler.run(a.data(), b.data(), c.data(), n, opt.tile, prof);
+		std::cout << "Work stealing, tiles of " << opt.tile << " elements: " << sw.elapsedMs() << " ms\n";
+		scheduler.printStats(std::cout);
+		if (prof)
+		{
+			prof->printSummary(std::cout);
+			prof->writeChromeTrace(opt.profile);
+		}
+
+		// Check result from a random place, must be 0.001 without --random
+		srand(time(NULL));
+		std::cout << c[rand() % n] << std::endl;
+		return 0;
+	}
+
+	// Get the CL device, context and command queue; without them the host engine takes over
+	Runtime::setProfiling(!opt.profile.empty());
+	Runtime* runtime = opt.host ? nullptr : Runtime::tryInstance();
+	if (!runtime)
+	{
+		std::unique_ptr<PowEngine> engine = createHostPowEngine(opt.hostSimd);
+		std::vector<double> a(n, 0.1), b(n, 3.0), c(n);
+		if (opt.random)
+			randomHost(bases, opt.seed, 0, n, a.data());
+
+		Stopwatch sw;
+		engine->pow(a.data(), b.data(), c.data(), n);
+		std::cout << engine->name() << ": " << sw.elapsedMs() << " ms, peak RSS " << peakRSS_MiB() << " MiB\n";
+
+		// Check result from a random place, must be 0.001 without --random
+		srand(time(NULL));
+		std::cout << c[rand() % n] << std::endl;
+		return 0;
+	}
+
+	Runtime& rt = *runtime;
+	const cl::Device& device = rt.device();
+	const cl::Context& context = rt.context();
+	const cl::CommandQueue& queue = rt.queue();
+
+	if (opt.benchPrecision)
+	{
+		benchPrecisions(rt, n);
+		return 0;
+	}
+
+	if (opt.benchStorage)
+	{
+		benchStorage(rt, n);
+		return 0;
+	}
+
+	// The exponent is the same for every element: it goes as a kernel argument rather than as
+	// n copies in a buffer
+	const Operand exponent(3.0);
+
+	// Packed storage cuts the bytes moved per element from 24 (16 with the scalar exponent) to
+	// 8 for float or 4 for half; the kernel still computes in double where the device has it
+	if (opt.storage != Storage::Double)
+	{
+		std::vector<double> a(n, 0.1), c(n);
+		if (opt.random)
+			randomHost(bases, opt.seed, 0, n, a.data());
+		Profiler profiler;
+		Profiler* prof = opt.profile.empty() ? nullptr : &profiler;
+		const bool computeDouble = hasCL_DoublePrecision(device);
+
+		Stopwatch sw;
+		powCL_Packed(rt, opt.storage, computeDouble, a.data(), nullptr, exponent.value(), c.data(), n, prof);
+		std::cout << "Single pass, " << toString(opt.storage) << " storage computed in "
+			<< (computeDouble ? "double" : "float") << ": " << sw.elapsedMs() << " ms, peak RSS "
+			<< peakRSS_MiB() << " MiB\n";
+		if (prof)
+		{
+			prof->printSummary(std::cout);
+			prof->writeChromeTrace(opt.profile);
+		}
+
+		// Check result from a random place, about 0.001 after rounding to the storage format without
+		// --random
+		srand(time(NULL));
+		std::cout << c[rand() % n] << std::endl;
+		return 0;
+	}
+
+	// Without double precision on the device, float or double-float arithmetic takes over
+	const Precision precision = opt.precisionSet ? opt.precision : defaultCL_Precision(device);
+	if (precision != Precision::Double)
+	{
+		std::vector<double> a(n, 0.1), c(n);
+		if (opt.random)
+			randomHost(bases, opt.seed, 0, n, a.data());
+		Profiler profiler;
+		Profiler* prof = opt.profile.empty() ? nullptr : &profiler;
+
+		Stopwatch sw;
+		powCL_Reduced(rt, precision, a.data(), nullptr, exponent.value(), c.data(), n, prof);
+		std::cout << "Single pass in " << toString(precision) << ": " << sw.elapsedMs() << " ms, peak RSS "
+			<< peakRSS_MiB() << " MiB\n";
+		if (prof)
+		{
+			prof->printSummary(std::cout);
+			prof->writeChromeTrace(opt.profile);
+		}
+
+		// Check result from a random place, must be 0.001 without --random
+		srand(time(NULL));
+		std::cout << c[rand() % n] << std::endl;
+		return 0;
+	}
+	if (!hasCL_DoublePrecision(device))
+		throw std::domain_error(device.getInfo<CL_DEVICE_NAME>() + " has no double precision, "
+			"use --precision float or double-float");
+
+	if (opt.benchCache)
+	{
+		benchProgramCache(context, device, 5);
+		return 0;
+	}
+
+	if (opt.benchVector)
+	{
+		benchVectorWidths(rt, n);
+		return 0;
+	}
+
+	if (opt.benchIntPow)
+	{
+		benchIntegerPow(rt, n);
+		return 0;
+	}
+
+	if (opt.benchMath)
+	{
+		benchMathModes(rt, n, opt.tolerance);
+		return 0;
+	}
+
+	if (opt.benchFusion)
+	{
+		benchFusion(rt, n);
+		return 0;
+	}
+
+	if (opt.benchReduce)
+	{
+		benchReductions(rt, n);
+		return 0;
+	}
 
-	// Prepare input data.
-	std::vector<double> a(N, 0.1);
-	std::vector<double> b(N, 3.0);
-	std::vector<double> c(N);
+	if (opt.benchCompact)
+	{
+		benchCompaction(rt, n);
+		return 0;
+	}
 
-	// Allocate device buffers and transfer input data to device
-	cl::Buffer A(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, a.size() * sizeof(double), a.data());
-	cl::Buffer B(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, b.size() * sizeof(double), b.data());
-	cl::Buffer C(context, CL_MEM_READ_WRITE, c.size() * sizeof(double));
+	if (opt.benchSort)
+	{
+		benchSort(rt, n);
+		return 0;
+	}
 
-	// Set kernel parameters
-	k1.setArg(0, static_cast<cl_ulong>(N));
-	k1.setArg(1, A);
-	k1.setArg(2, B);
-	k1.setArg(3, C);
+	if (opt.benchInit)
+	{
+		benchInit(rt, n);
+		return 0;
+	}
+
+	// Compile OpenCL program for found device, or load it from the program cache
+	cl::Program program = rt.program(kernel1);
+
+	// Kernel of the single pass with the launch geometry tuned for the device, which an earlier
+	// run has usually saved; with --no-tune the variant matching the device's vector width
+	LaunchConfig launch;
+	cl::Kernel k1(program, "entry_point");
 
-	// Launch kernel on the compute device
-	queue.enqueueNDRangeKernel(k1, cl::NullRange, N, cl::NullRange);
+	// The kernel variant only depends on the kinds of the operands
+	const Operand base = cl::Buffer();
+	if (!opt.stream && !opt.zeroCopy)
+	{
+		launch = opt.tune ? getCL_LaunchConfig(rt, opt.retune) : deviceCL_LaunchConfig(device);
+		const PowPath path = selectCL_PowPath(rt, exponent, n);
+		k1 = powCL_Kernel(rt, launch, base, exponent, path, opt.math);
+		std::cout << "Launch: " << toString(launch) << ", " << toString(path) << " path\n";
+		if (opt.math != MathMode::Strict && path != PowPath::General)
+			std::cout << "Note: --math " << toString(opt.math) << " only applies to the general path, the "
+				<< toString(path) << " path doesn't call pow\n";
+	}
+	else if (opt.math != MathMode::Strict)
+		std::cout << "Note: --math " << toString(opt.math) << " only applies to the single pass\n";
 
-	// Get result back to host
-	queue.enqueueReadBuffer(C, CL_TRUE, 0, c.size() * sizeof(double), c.data());
+	Profiler profiler;
+	Profiler* prof = rt.profiling() ? &profiler : nullptr;
 
-	// Check result from a random place, must be 0.001
+	// End-to-end time includes preparing the inputs
+	Stopwatch sw;
 	srand(time(NULL));
-	std::cout << c[rand() % N] << std::endl;
+
+	if (opt.zeroCopy)
+	{
+		double sample = 0.0;
+		ZeroCopyMode mode = powCL_ZeroCopy(context, device, queue, program, n,
+			[&](double* a, double* b, size_t n) {
+				if (opt.random)
+					randomHost(bases, opt.seed, 0, n, a);
+				else
+					std::fill(a, a + n, 0.1);
+				std::fill(b, b + n, 3.0);
+			},
+			[&sample](const double* c, size_t n) { sample = c[rand() % n]; }, ZeroCopyMode::Auto, prof);
+		std::cout << "Zero-copy (" << toString(mode) << "): " << sw.elapsedMs() << " ms, peak RSS "
+			<< peakRSS_MiB() << " MiB\n";
+		if (prof)
+		{
+			prof->printSummary(std::cout);
+			prof->writeChromeTrace(opt.profile);
+			std::cout << "Trace written to " << opt.profile << "\n";
+		}
+
+		// Check result from a random place, must be 0.001 without --random
+		std::cout << sample << std::endl;
+		return 0;
+	}
+
+	double sample = 0.0;
+
+	if (opt.stream)
+	{
+		// Overlap transfers with compute, chunk by chunk. Only streaming needs the inputs and
+		// the whole result in host memory.
+		std::vector<double> a(n, 0.1);
+		if (opt.random)
+			randomHost(bases, opt.seed, 0, n, a.data());
+		std::vector<double> b(n, exponent.value());
+		std::vector<double> c(n);
+		powCL_Stream(context, device, program, a.data(), b.data(), c.data(), n, opt.chunk, opt.depth, prof);
+		std::cout << "Streamed in chunks of " << opt.chunk << " elements, " << opt.depth << " in flight: "
+			<< sw.elapsedMs() << " ms, peak RSS " << peakRSS_MiB() << " MiB\n";
+		sample = c[rand() % n];
+	}
+	else
+	{
+		// The input is made on the device, filled with the constant or generated by a kernel (so
+		// read-write then), without host memory or a transfer. The result stays on the device and
+		// only the element checked below comes back. C must stay read-write: ocl::validate reads
+		// on the device what entry_point wrote there.
+		const size_t bytes = n * sizeof(double);
+		ocl::DeviceVector<double> A(rt, n, opt.random ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY);
+		ocl::DeviceVector<double> C(rt, n);
+		cl::Event uploaded = opt.random ? ocl::fillRandom(A, bases, opt.seed) : A.fill(0.1);
+
+		// Launch kernel on the compute device
+		cl::Event computed = enqueueCL_Pow(queue, k1, launch, n, A.buffer(), exponent, C.bufferForWriting());
+
+		const size_t at = rand() % n;
+		std::vector<cl::Event> sampled;
+		C.read(at, 1, &sample, &sampled);
+		std::cout << "Single pass: " << sw.elapsedMs() << " ms, peak RSS " << peakRSS_MiB() << " MiB\n";
+
+		if (prof)
+		{
+			if (opt.random)
+				prof->record("philox_fill", Profiler::Kernel, uploaded, n);
+			else
+				prof->record("fill A", Profiler::Write, uploaded, bytes);
+			prof->record("entry_point", Profiler::Kernel, computed, n);
+			prof->record("map C", Profiler::Read, sampled.at(0), sizeof(double));
+			prof->record("unmap C", Profiler::Other, sampled.at(1), 0);
+		}
+
+		// Every element checked on the device, only the summary comes back. Random bases are
+		// checked against the plain pow of the expression kernel, and the sampled element
+		// against the host's pow of the same base.
+		const ValidationSummary check = opt.random ? ocl::validate(C, ocl::pow(A, exponent.value()), prof)
+			: ocl::validate(C, 0.001, prof);
+		std::cout << "Validation: " << toString(check) << "\n";
+		if (opt.random)
+		{
+			double base = 0.0;
+			randomHost(bases, opt.seed, at, 1, &base);
+			std::cout << "Element " << at << ": pow(" << base << ", " << exponent.value() << ") = " << sample
+				<< ", host " << std::pow(base, exponent.value()) << "\n";
+		}
+	}
+
+	if (prof)
+	{
+		prof->printSummary(std::cout);
+		prof->writeChromeTrace(opt.profile);
+		std::cout << "Trace written to " << opt.profile << "\n";
+	}
+
+	// Check result from a random place, must be 0.001 without --random
+	std::cout << sample << std::endl;
 
 	return 0;
 }
@@ -0,0 +1,28 @@
+#include "expression.h"
+#include "runtime.h"
+#include "utils.h"
+
+namespace ocl {
+
+cl::Kernel fusedCL_Kernel(Runtime& rt, const std::string& result, const std::string& params,
+	const std::string& body)
+{
+	const std::string name = "fused_" + toHex(fnv1a64(result + "|" + params + "|" + body));
+	const std::string source =
+		"#if defined(cl_khr_fp64)\n"
+		"#  pragma OPENCL EXTENSION cl_khr_fp64: enable\n"
+		"#elif defined(cl_amd_fp64)\n"
+		"#  pragma OPENCL EXTENSION cl_amd_fp64: enable\n"
+		"#endif\n"
+		"kernel\n"
+		"void " + name + "(ulong n, global " + result + " *out" + params + ")\n"
+		"{\n"
+		"    size_t i = get_global_id(0);\n"
+		"    if (i < n)\n"
+		"        out[i] = (" + result + ")" + body + ";\n"
+		"}\n";
+	// A kernel object of its own: arguments are set per evaluation
+	return cl::Kernel(rt.program(source), name.c_str());
+}
+
+} // namespace ocl
@@ -0,0 +1,249 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+class Runtime;
+
+// Elementwise expressions over device vectors, e.g. r = sqrt(pow(a, b) + c). Operators and
+// functions only build a tree of types; assigning it to a DeviceVector (device_vector.h)
+// generates one kernel for the whole tree, so intermediate values stay in registers instead
+// of going through global memory. The source depends only on the tree's type, it is generated
+// once per shape and the program is built once per runtime (and kept in the program cache).
+namespace ocl {
+
+// OpenCL C name of an element type
+template<class T> struct ClType;
+template<> struct ClType<int32_t> { static const char* name() { return "int"; } };
+template<> struct ClType<uint32_t> { static const char* name() { return "uint"; } };
+template<> struct ClType<int64_t> { static const char* name() { return "long"; } };
+template<> struct ClType<uint64_t> { static const char* name() { return "ulong"; } };
+template<> struct ClType<float> { static const char* name() { return "float"; } };
+template<> struct ClType<double> { static const char* name() { return "double"; } };
+
+// Base of every node, only there to let the operators below match expressions and nothing else
+template<class E>
+struct Expression
+{
+	const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// How a node holds an operand: by value, except for containers which specialise it to a
+// reference to their buffer (see VectorRef in device_vector.h)
+template<class E>
+struct Stored
+{
+	typedef E type;
+};
+
+// Nodes generate their part of the kernel with static functions, numbering the leaves in
+// order: declare() appends the kernel parameters, code() the expression for element i.
+// At run time setArgs() passes the leaves in the same order and size() is the element count,
+// 0 for scalars which are broadcast.
+
+// A value broadcast to every element, passed as a kernel argument
+template<class T>
+class Scalar : public Expression<Scalar<T>>
+{
+public:
+	typedef T value_type;
+
+	explicit Scalar(T value) : m_value(value) {}
+
+	static void declare(std::string& params, unsigned& leaf)
+	{
+		params += std::string(", ") + ClType<T>::name() + " x" + std::to_string(leaf++);
+	}
+
+	static void code(std::string& body, unsigned& leaf)
+	{
+		body += "x" + std::to_string(leaf++);
+	}
+
+	void setArgs(cl::Kernel& kernel, cl_uint& arg) const { kernel.setArg(arg++, m_value); }
+	size_t size() const { return 0; }
+
+private:
+	T m_value;
+};
+
+// Operators and functions: text before, between and after the operands
+#define OCL_OPERATION(Name, Before, Between, After) \
+	struct Name \
+	{ \
+		static const char* before() { return Before; } \
+		static const char* between() { return Between; } \
+		static const char* after() { return After; } \
+	};
+
+OCL_OPERATION(Add, "(", " + ", ")")
+OCL_OPERATION(Sub, "(", " - ", ")")
+OCL_OPERATION(Mul, "(", " * ", ")")
+OCL_OPERATION(Div, "(", " / ", ")")
+OCL_OPERATION(Neg, "(-", "", ")")
+OCL_OPERATION(Pow, "pow(", ", ", ")")
+OCL_OPERATION(Fmin, "fmin(", ", ", ")")
+OCL_OPERATION(Fmax, "fmax(", ", ", ")")
+OCL_OPERATION(Sqrt, "sqrt(", "", ")")
+OCL_OPERATION(Exp, "exp(", "", ")")
+OCL_OPERATION(Log, "log(", "", ")")
+OCL_OPERATION(Fabs, "fabs(", "", ")")
+OCL_OPERATION(Sin, "sin(", "", ")")
+OCL_OPERATION(Cos, "cos(", "", ")")
+
+#undef OCL_OPERATION
+
+template<class Op, class A>
+class Unary : public Expression<Unary<Op, A>>
+{
+	typedef typename Stored<A>::type Operand;
+
+public:
+	typedef typename Operand::value_type value_type;
+
+	explicit Unary(const A& a) : m_a(a) {}
+
+	static void declare(std::string& params, unsigned& leaf) { Operand::declare(params, leaf); }
+
+	static void code(std::string& body, unsigned& leaf)
+	{
+		body += Op::before();
+		Operand::code(body, leaf);
+		body += Op::after();
+	}
+
+	void setArgs(cl::Kernel& kernel, cl_uint& arg) const { m_a.setArgs(kernel, arg); }
+	size_t size() const { return m_a.size(); }
+
+private:
+	Operand m_a;
+};
+
+template<class Op, class L, class R>
+class Binary : public Expression<Binary<Op, L, R>>
+{
+	typedef typename Stored<L>::type Left;
+	typedef typename Stored<R>::type Right;
+
+public:
+	typedef typename std::common_type<typename Left::value_type, typename Right::value_type>::type value_type;
+
+	Binary(const L& l, const R& r) : m_l(l), m_r(r) {}
+
+	static void declare(std::string& params, unsigned& leaf)
+	{
+		Left::declare(params, leaf);
+		Right::declare(params, leaf);
+	}
+
+	static void code(std::string& body, unsigned& leaf)
+	{
+		body += Op::before();
+		Left::code(body, leaf);
+		body += Op::between();
+		Right::code(body, leaf);
+		body += Op::after();
+	}
+
+	void setArgs(cl::Kernel& kernel, cl_uint& arg) const
+	{
+		m_l.setArgs(kernel, arg);
+		m_r.setArgs(kernel, arg);
+	}
+
+	size_t size() const
+	{
+		const size_t l = m_l.size(), r = m_r.size();
+		if (l && r && l != r)
+			throw std::invalid_argument("Elementwise expression over vectors of " + std::to_string(l) + " and "
+				+ std::to_string(r) + " elements");
+		return l ? l : r;
+	}
+
+private:
+	Left m_l;
+	Right m_r;
+};
+
+// Binary operations on two expressions, or on an expression and a number which takes the
+// expression's element type (so that 2.0 * floats stays in float)
+#define OCL_BINARY(Op, function) \
+	template<class L, class R> \
+	inline Binary<Op, L, R> function(const Expression<L>& l, const Expression<R>& r) \
+	{ \
+		return Binary<Op, L, R>(l.self(), r.self()); \
+	} \
+	template<class L, class S> \
+	inline typename std::enable_if<std::is_arithmetic<S>::value, \
+		Binary<Op, L, Scalar<typename Stored<L>::type::value_type>>>::type \
+	function(const Expression<L>& l, S r) \
+	{ \
+		typedef Scalar<typename Stored<L>::type::value_type> Value; \
+		return Binary<Op, L, Value>(l.self(), Value(static_cast<typename Value::value_type>(r))); \
+	} \
+	template<class S, class R> \
+	inline typename std::enable_if<std::is_arithmetic<S>::value, \
+		Binary<Op, Scalar<typename Stored<R>::type::value_type>, R>>::type \
+	function(S l, const Expression<R>& r) \
+	{ \
+		typedef Scalar<typename Stored<R>::type::value_type> Value; \
+		return Binary<Op, Value, R>(Value(static_cast<typename Value::value_type>(l)), r.self()); \
+	}
+
+OCL_BINARY(Add, operator+)
+OCL_BINARY(Sub, operator-)
+OCL_BINARY(Mul, operator*)
+OCL_BINARY(Div, operator/)
+OCL_BINARY(Pow, pow)
+OCL_BINARY(Fmin, fmin)
+OCL_BINARY(Fmax, fmax)
+
+#undef OCL_BINARY
+
+#define OCL_UNARY(Op, function) \
+	template<class A> \
+	inline Unary<Op, A> function(const Expression<A>& a) \
+	{ \
+		return Unary<Op, A>(a.self()); \
+	}
+
+OCL_UNARY(Neg, operator-)
+OCL_UNARY(Sqrt, sqrt)
+OCL_UNARY(Exp, exp)
+OCL_UNARY(Log, log)
+OCL_UNARY(Fabs, fabs)
+OCL_UNARY(Sin, sin)
+OCL_UNARY(Cos, cos)
+
+#undef OCL_UNARY
+
+// Kernel "fused_<hash of the structure>" computing out[i] = (result)(body) for i < n, with
+// parameters (ulong n, global result *out<params>). Built once per runtime.
+cl::Kernel fusedCL_Kernel(Runtime& rt, const std::string& result, const std::string& params,
+	const std::string& body);
+
+// Parameters and body of the kernel of expression type E, generated on first use
+template<class E>
+const std::pair<std::string, std::string>& fusedSource()
+{
+	static const std::pair<std::string, std::string> source = [] {
+		std::pair<std::string, std::string> s;
+		unsigned leaf = 0;
+		E::declare(s.first, leaf);
+		leaf = 0;
+		E::code(s.second, leaf);
+		return s;
+	}();
+	return source;
+}
+
+} // namespace ocl
+
+#endif // EXPRESSION_H
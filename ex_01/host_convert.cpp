@@ -0,0 +1,163 @@
+#include "host_convert.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(OCL_HOST_F16C)
+#  include <intrin.h>
+#endif
+
+// Vectorized bodies, in a translation unit built for AVX2 and F16C. They convert a multiple of
+// 8 elements and return how many, the caller finishes the tail.
+#if defined(OCL_HOST_F16C)
+size_t convertToHalfF16C(const double* src, uint16_t* dst, size_t n);
+size_t convertFromHalfF16C(const uint16_t* src, double* dst, size_t n);
+size_t convertToFloatAvx(const double* src, float* dst, size_t n);
+size_t convertFromFloatAvx(const float* src, double* dst, size_t n);
+#endif
+
+namespace {
+
+uint32_t bitsOf(float f)
+{
+	uint32_t u;
+	std::memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+float floatOf(uint32_t u)
+{
+	float f;
+	std::memcpy(&f, &u, sizeof(f));
+	return f;
+}
+
+// Rounded to float toward zero with the last bit set when inexact ("round to odd"), so that the
+// second rounding to half can't create a wrong tie
+float toFloatOdd(double d)
+{
+	float f = static_cast<float>(d);
+	if (static_cast<double>(f) == d || std::isnan(d))
+		return f;
+
+	uint32_t u = bitsOf(f);
+	if (std::fabs(static_cast<double>(f)) > std::fabs(d))
+		--u;
+	return floatOf(u | 1);
+}
+
+// Round to nearest even, after F. Giesen's float_to_half_fast3_rtne
+uint16_t floatToHalf(float value)
+{
+	const uint32_t F32_INF = 255u << 23;
+	const uint32_t F16_MAX = (127u + 16) << 23;
+	const uint32_t DENORM_MAGIC = ((127u - 15) + (23 - 10) + 1) << 23;
+
+	uint32_t x = bitsOf(value);
+	const uint32_t sign = x & 0x80000000u;
+	x ^= sign;
+
+	uint16_t h;
+	if (x >= F16_MAX)
+		h = x > F32_INF ? 0x7e00 : 0x7c00; // NaN stays a (quiet) NaN, the rest overflows to inf
+	else if (x < (113u << 23))
+		h = static_cast<uint16_t>(bitsOf(floatOf(x) + floatOf(DENORM_MAGIC)) - DENORM_MAGIC); // subnormal
+	else
+	{
+		const uint32_t odd = (x >> 13) & 1;
+		x += ((15u - 127) << 23) + 0xfff + odd;
+		h = static_cast<uint16_t>(x >> 13);
+	}
+	return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+float halfToFloat(uint16_t h)
+{
+	const uint32_t MAGIC = 113u << 23;
+	const uint32_t SHIFTED_EXP = 0x7c00u << 13;
+
+	uint32_t u = (h & 0x7fffu) << 13;
+	const uint32_t exp = u & SHIFTED_EXP;
+	u += (127u - 15) << 23;
+	if (exp == SHIFTED_EXP)
+		u += (128u - 16) << 23; // inf, NaN
+	else if (!exp)
+		u = bitsOf(floatOf(u + (1u << 23)) - floatOf(MAGIC)); // subnormal
+	return floatOf(u | ((h & 0x8000u) << 16));
+}
+
+} // namespace
+
+bool hasHostF16C()
+{
+#if defined(OCL_HOST_F16C) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	const bool f16c = (info[2] & (1 << 29)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!f16c || !osxsave || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(OCL_HOST_F16C)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+#else
+	return false;
+#endif
+}
+
+void convertToHalf(const double* src, uint16_t* dst, size_t n, bool simd)
+{
+	size_t i = 0;
+#if defined(OCL_HOST_F16C)
+	if (simd && hasHostF16C())
+		i = convertToHalfF16C(src, dst, n);
+#else
+	(void)simd;
+#endif
+	for (; i < n; ++i)
+		dst[i] = floatToHalf(toFloatOdd(src[i]));
+}
+
+void convertFromHalf(const uint16_t* src, double* dst, size_t n, bool simd)
+{
+	size_t i = 0;
+#if defined(OCL_HOST_F16C)
+	if (simd && hasHostF16C())
+		i = convertFromHalfF16C(src, dst, n);
+#else
+	(void)simd;
+#endif
+	for (; i < n; ++i)
+		dst[i] = halfToFloat(src[i]);
+}
+
+void convertToFloat(const double* src, float* dst, size_t n, bool simd)
+{
+	size_t i = 0;
+#if defined(OCL_HOST_F16C)
+	if (simd && hasHostF16C())
+		i = convertToFloatAvx(src, dst, n);
+#else
+	(void)simd;
+#endif
+	for (; i < n; ++i)
+		dst[i] = static_cast<float>(src[i]);
+}
+
+void convertFromFloat(const float* src, double* dst, size_t n, bool simd)
+{
+	size_t i = 0;
+#if defined(OCL_HOST_F16C)
+	if (simd && hasHostF16C())
+		i = convertFromFloatAvx(src, dst, n);
+#else
+	(void)simd;
+#endif
+	for (; i < n; ++i)
+		dst[i] = src[i];
+}
@@ -0,0 +1,22 @@
+#ifndef HOST_CONVERT_H
+#define HOST_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversions between the host's doubles and packed storage formats, all rounding to nearest
+// even. With 'simd' they use F16C and AVX2 when the CPU has them, which is about an order of
+// magnitude faster than the portable code; both give identical results.
+
+// IEEE binary16 as its bit pattern. Doubles are rounded once, not through float, so halfway
+// cases of the half grid round correctly.
+void convertToHalf(const double* src, uint16_t* dst, size_t n, bool simd = true);
+void convertFromHalf(const uint16_t* src, double* dst, size_t n, bool simd = true);
+
+void convertToFloat(const double* src, float* dst, size_t n, bool simd = true);
+void convertFromFloat(const float* src, double* dst, size_t n, bool simd = true);
+
+// The CPU has F16C and AVX2, and this build has the code for them
+bool hasHostF16C();
+
+#endif // HOST_CONVERT_H
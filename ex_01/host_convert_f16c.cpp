@@ -0,0 +1,78 @@
+// AVX2 + F16C bodies of host_convert.cpp, this file is built with those instruction sets enabled
+#if defined(OCL_HOST_F16C)
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+namespace {
+
+// 4 doubles to float rounded to odd, see toFloatOdd() in host_convert.cpp
+inline __m128 toFloatOdd(__m256d d)
+{
+	const __m256d ABS = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+	const __m256i LOW_HALVES = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+	__m128 f = _mm256_cvtpd_ps(d);
+	__m256d back = _mm256_cvtps_pd(f);
+	__m256d inexact = _mm256_cmp_pd(back, d, _CMP_NEQ_OQ);
+	__m256d above = _mm256_cmp_pd(_mm256_and_pd(back, ABS), _mm256_and_pd(d, ABS), _CMP_GT_OQ);
+
+	// 64-bit lane masks down to 32 bits
+	__m128i inexact32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(inexact), LOW_HALVES));
+	__m128i above32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(above), LOW_HALVES));
+
+	// One step toward zero where rounding went up (the mask is -1), then the sticky bit
+	__m128i bits = _mm_add_epi32(_mm_castps_si128(f), above32);
+	bits = _mm_or_si128(bits, _mm_and_si128(inexact32, _mm_set1_epi32(1)));
+	return _mm_castsi128_ps(bits);
+}
+
+} // namespace
+
+size_t convertToHalfF16C(const double* src, uint16_t* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 f = _mm256_set_m128(toFloatOdd(_mm256_loadu_pd(src + i + 4)), toFloatOdd(_mm256_loadu_pd(src + i)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+	}
+	return i;
+}
+
+size_t convertFromHalfF16C(const uint16_t* src, double* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 f = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		_mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm256_castps256_ps128(f)));
+		_mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)));
+	}
+	return i;
+}
+
+size_t convertToFloatAvx(const double* src, float* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+		_mm_storeu_ps(dst + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4)));
+	}
+	return i;
+}
+
+size_t convertFromFloatAvx(const float* src, double* dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+		_mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+	}
+	return i;
+}
+
+#endif // OCL_HOST_F16C
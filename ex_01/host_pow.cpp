@@ -0,0 +1,141 @@
+#include "host_pow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(OCL_HOST_AVX2) || defined(OCL_HOST_AVX512))
+#  include <intrin.h>
+#  include <immintrin.h>
+#endif
+
+// Per-ISA entry points, each in a translation unit built for its instruction set
+#if defined(OCL_HOST_AVX2)
+void powHostAvx2(const double* a, const double* b, double* c, size_t n);
+#endif
+#if defined(OCL_HOST_AVX512)
+void powHostAvx512(const double* a, const double* b, double* c, size_t n);
+#endif
+
+namespace {
+
+// Below this many elements a single thread is faster than starting more
+const size_t MIN_ELEMENTS_PER_THREAD = 1 << 16;
+
+void powScalar(const double* a, const double* b, double* c, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		c[i] = std::pow(a[i], b[i]);
+}
+
+#if defined(_MSC_VER) && (defined(OCL_HOST_AVX2) || defined(OCL_HOST_AVX512))
+bool cpuSupports(HostSimd isa)
+{
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave)
+		return false;
+	unsigned long long xcr0 = _xgetbv(0);
+	__cpuidex(info, 7, 0);
+	if (isa == HostSimd::Avx512)
+		return (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+	return fma && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+}
+#elif defined(OCL_HOST_AVX2) || defined(OCL_HOST_AVX512)
+bool cpuSupports(HostSimd isa)
+{
+	__builtin_cpu_init();
+	if (isa == HostSimd::Avx512)
+		return __builtin_cpu_supports("avx512f");
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+#endif
+
+typedef void (*PowFn)(const double*, const double*, double*, size_t);
+
+PowFn selectFn(HostSimd isa)
+{
+	switch (isa)
+	{
+	case HostSimd::Scalar:
+		return powScalar;
+#if defined(OCL_HOST_AVX2)
+	case HostSimd::Avx2:
+		if (cpuSupports(isa))
+			return powHostAvx2;
+		break;
+#endif
+#if defined(OCL_HOST_AVX512)
+	case HostSimd::Avx512:
+		if (cpuSupports(isa))
+			return powHostAvx512;
+		break;
+#endif
+	default:
+		break;
+	}
+	throw std::domain_error(std::string(toString(isa)) + " is not available on this host.");
+}
+
+} // namespace
+
+const char* toString(HostSimd isa)
+{
+	switch (isa)
+	{
+	case HostSimd::Scalar:
+		return "SCALAR";
+	case HostSimd::Avx2:
+		return "AVX2";
+	case HostSimd::Avx512:
+		return "AVX512";
+	}
+	return "";
+}
+
+HostSimd detectHostSimd()
+{
+#if defined(OCL_HOST_AVX512)
+	if (cpuSupports(HostSimd::Avx512))
+		return HostSimd::Avx512;
+#endif
+#if defined(OCL_HOST_AVX2)
+	if (cpuSupports(HostSimd::Avx2))
+		return HostSimd::Avx2;
+#endif
+	return HostSimd::Scalar;
+}
+
+void powHost(const double* a, const double* b, double* c, size_t n, HostSimd isa, unsigned threads)
+{
+	PowFn fn = selectFn(isa);
+
+	if (!threads)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, n / MIN_ELEMENTS_PER_THREAD)));
+
+	if (threads == 1)
+	{
+		fn(a, b, c, n);
+		return;
+	}
+
+	// Contiguous slices, aligned to the widest vector so only the last one has a scalar tail
+	const size_t slice = (n / threads + 7) & ~size_t(7);
+	std::vector<std::thread> pool;
+	for (size_t begin = 0; begin < n; begin += slice)
+	{
+		const size_t count = std::min(slice, n - begin);
+		pool.push_back(std::thread(fn, a + begin, b + begin, c + begin, count));
+	}
+	for (auto& t : pool)
+		t.join();
+}
@@ -0,0 +1,23 @@
+#ifndef HOST_POW_H
+#define HOST_POW_H
+
+#include <cstddef>
+
+// Host instruction sets the pow engine can run on
+enum class HostSimd {
+	Scalar,  // std::pow per element
+	Avx2,    // AVX2 + FMA, 4 lanes
+	Avx512   // AVX-512F, 8 lanes
+};
+
+const char* toString(HostSimd isa);
+
+// Widest instruction set supported by both the build and the running CPU
+HostSimd detectHostSimd();
+
+// c[i] = pow(a[i], b[i]) on the host, split across 'threads' threads (0: one per core).
+// The vector paths are within 1 ULP of the correctly rounded result for x > 0 normal, y finite
+// and a normal result; every other case is delegated to std::pow. isa must be supported.
+void powHost(const double* a, const double* b, double* c, size_t n, HostSimd isa, unsigned threads = 0);
+
+#endif // HOST_POW_H
@@ -0,0 +1,57 @@
+// AVX2 + FMA instantiation of the vectorized pow, built with the matching compiler flags
+#if defined(OCL_HOST_AVX2)
+
+#include "host_pow_simd.h"
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2
+{
+	typedef __m256d V;
+	typedef __m256i I;
+	typedef __m256d M;
+
+	static const size_t width = 4;
+	static const unsigned full = 0xF;
+
+	static V load(const double* p) { return _mm256_loadu_pd(p); }
+	static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+	static V set(double x) { return _mm256_set1_pd(x); }
+	static I seti(long long x) { return _mm256_set1_epi64x(x); }
+
+	static V add(V a, V b) { return _mm256_add_pd(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+	static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+	static V div(V a, V b) { return _mm256_div_pd(a, b); }
+	static V fma(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+	static V fms(V a, V b, V c) { return _mm256_fmsub_pd(a, b, c); }
+	static V fnma(V a, V b, V c) { return _mm256_fnmadd_pd(a, b, c); }
+	static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+	static V round(V a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+	static I asInt(V a) { return _mm256_castpd_si256(a); }
+	static V asDouble(I a) { return _mm256_castsi256_pd(a); }
+	static I andi(I a, I b) { return _mm256_and_si256(a, b); }
+	static I ori(I a, I b) { return _mm256_or_si256(a, b); }
+	static I addi(I a, I b) { return _mm256_add_epi64(a, b); }
+	template <int N> static I srli(I a) { return _mm256_srli_epi64(a, N); }
+	template <int N> static I slli(I a) { return _mm256_slli_epi64(a, N); }
+
+	static M gt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static M ge(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+	static M le(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+	static M andm(M a, M b) { return _mm256_and_pd(a, b); }
+	static V blend(M m, V yes, V no) { return _mm256_blendv_pd(no, yes, m); }
+	static unsigned bits(M m) { return static_cast<unsigned>(_mm256_movemask_pd(m)); }
+};
+
+} // namespace
+
+void powHostAvx2(const double* a, const double* b, double* c, size_t n)
+{
+	simd_pow::powArray<Avx2>(a, b, c, n);
+}
+
+#endif // OCL_HOST_AVX2
@@ -0,0 +1,57 @@
+// AVX-512F instantiation of the vectorized pow, built with the matching compiler flags
+#if defined(OCL_HOST_AVX512)
+
+#include "host_pow_simd.h"
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx512
+{
+	typedef __m512d V;
+	typedef __m512i I;
+	typedef __mmask8 M;
+
+	static const size_t width = 8;
+	static const unsigned full = 0xFF;
+
+	static V load(const double* p) { return _mm512_loadu_pd(p); }
+	static void store(double* p, V v) { _mm512_storeu_pd(p, v); }
+	static V set(double x) { return _mm512_set1_pd(x); }
+	static I seti(long long x) { return _mm512_set1_epi64(x); }
+
+	static V add(V a, V b) { return _mm512_add_pd(a, b); }
+	static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+	static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+	static V div(V a, V b) { return _mm512_div_pd(a, b); }
+	static V fma(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+	static V fms(V a, V b, V c) { return _mm512_fmsub_pd(a, b, c); }
+	static V fnma(V a, V b, V c) { return _mm512_fnmadd_pd(a, b, c); }
+	static V abs(V a) { return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(0x7fffffffffffffffLL))); }
+	static V round(V a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+	static I asInt(V a) { return _mm512_castpd_si512(a); }
+	static V asDouble(I a) { return _mm512_castsi512_pd(a); }
+	static I andi(I a, I b) { return _mm512_and_si512(a, b); }
+	static I ori(I a, I b) { return _mm512_or_si512(a, b); }
+	static I addi(I a, I b) { return _mm512_add_epi64(a, b); }
+	template <int N> static I srli(I a) { return _mm512_srli_epi64(a, N); }
+	template <int N> static I slli(I a) { return _mm512_slli_epi64(a, N); }
+
+	static M gt(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+	static M ge(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+	static M le(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+	static M andm(M a, M b) { return static_cast<M>(a & b); }
+	static V blend(M m, V yes, V no) { return _mm512_mask_blend_pd(m, no, yes); }
+	static unsigned bits(M m) { return static_cast<unsigned>(m); }
+};
+
+} // namespace
+
+void powHostAvx512(const double* a, const double* b, double* c, size_t n)
+{
+	simd_pow::powArray<Avx512>(a, b, c, n);
+}
+
+#endif // OCL_HOST_AVX512
@@ -0,0 +1,188 @@
+#ifndef HOST_POW_SIMD_H
+#define HOST_POW_SIMD_H
+
+// Vectorized double precision pow shared by the per-ISA translation units.
+// Included by host_pow_avx2.cpp and host_pow_avx512.cpp only, each compiled for its own
+// instruction set; everything here has internal linkage so the copies never get merged.
+//
+// An ISA is described by a struct S providing the vector types V (double), I (int64) and M (lane
+// mask), 'width', 'full' (all lanes mask bits) and the operations used below.
+//
+// pow(x, y) = exp(y * ln(x)), with both steps carried in double-double:
+//   x = 2^e * m, m in [sqrt(1/2), sqrt(2)), ln(m) = 2 atanh(f), f = (m - 1) / (m + 1);
+//   exp(z) = 2^k * exp(r), |r| <= ln(2) / 2, with a degree 15 Taylor polynomial.
+// Lanes outside the fast domain (x <= 0 or not normal, y not finite, or a result which would
+// overflow or underflow to subnormals) are recomputed with std::pow.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+namespace simd_pow {
+
+const double SQRT2 = 1.4142135623730951;
+const double INV_LN2 = 1.4426950408889634;
+// Cody-Waite split of ln(2), the high part has 21 trailing zero bits so k * LN2_HI is exact
+const double LN2_HI = 6.93147180369123816490e-01;
+const double LN2_LO = 1.90821492927058770002e-10;
+const double TWO_THIRDS_HI = 0.6666666666666666;
+const double TWO_THIRDS_LO = 3.700743415417188e-17;
+const double TWO_FIFTHS_HI = 0.4;
+const double TWO_FIFTHS_LO = -2.2204460492503132e-17;
+// Results stay normal and finite inside this range of y * ln(x)
+const double Z_MIN = -708.0;
+const double Z_MAX = 709.0;
+
+// a + b = s + err exactly
+template <class S>
+inline void twoSum(typename S::V a, typename S::V b, typename S::V& s, typename S::V& err)
+{
+	typedef typename S::V V;
+	s = S::add(a, b);
+	V bb = S::sub(s, a);
+	err = S::add(S::sub(a, S::sub(s, bb)), S::sub(b, bb));
+}
+
+// Same for |a| >= |b|
+template <class S>
+inline void fastTwoSum(typename S::V a, typename S::V b, typename S::V& s, typename S::V& err)
+{
+	s = S::add(a, b);
+	err = S::sub(b, S::sub(s, a));
+}
+
+// Computes pow for every lane into 'out', returns the mask bits of the lanes which are valid
+template <class S>
+inline unsigned powLanes(typename S::V x, typename S::V y, typename S::V& out)
+{
+	typedef typename S::V V;
+	typedef typename S::I I;
+	typedef typename S::M M;
+
+	const V one = S::set(1.0);
+
+	M ok = S::andm(S::ge(x, S::set(2.2250738585072014e-308)), S::le(x, S::set(1.7976931348623157e308)));
+	ok = S::andm(ok, S::le(S::abs(y), S::set(1.7976931348623157e308)));
+
+	// x = 2^e * m
+	I xi = S::asInt(x);
+	V m = S::asDouble(S::ori(S::andi(xi, S::seti(0x000fffffffffffffLL)), S::seti(0x3ff0000000000000LL)));
+	// Biased exponent to double through the 2^52 magic number
+	V e = S::sub(S::asDouble(S::ori(S::template srli<52>(xi), S::seti(0x4330000000000000LL))),
+		S::set(4503599627370496.0 + 1023.0));
+	M big = S::gt(m, S::set(SQRT2));
+	m = S::blend(big, S::mul(m, S::set(0.5)), m);
+	e = S::blend(big, S::add(e, one), e);
+
+	// f = (m - 1) / (m + 1) as f_hi + f_lo
+	V u = S::sub(m, one);
+	V v_hi, v_lo;
+	twoSum<S>(m, one, v_hi, v_lo);
+	V f_hi = S::div(u, v_hi);
+	V rem = S::fnma(f_hi, v_hi, u);
+	rem = S::fnma(f_hi, v_lo, rem);
+	V f_lo = S::div(rem, v_hi);
+
+	// T = f^3 (2/3 + 2/5 f^2 + f^4 P(f^2)), the leading two terms in double-double.
+	// |y| can amplify the error of ln(x) by a thousand, so it has to stay near 2^-70.
+	V f2 = S::mul(f_hi, f_hi);
+	V f2_lo = S::fms(f_hi, f_hi, f2);
+	V f3 = S::mul(f2, f_hi);
+	V f3_lo = S::add(S::fms(f2, f_hi, f3), S::fma(f2_lo, f_hi, S::mul(S::mul(S::set(3.0), f2), f_lo)));
+
+	V p = S::set(0.07407407407407407);
+	p = S::fma(p, f2, S::set(0.08));
+	p = S::fma(p, f2, S::set(0.08695652173913043));
+	p = S::fma(p, f2, S::set(0.09523809523809523));
+	p = S::fma(p, f2, S::set(0.10526315789473684));
+	p = S::fma(p, f2, S::set(0.11764705882352941));
+	p = S::fma(p, f2, S::set(0.13333333333333333));
+	p = S::fma(p, f2, S::set(0.15384615384615385));
+	p = S::fma(p, f2, S::set(0.18181818181818182));
+	p = S::fma(p, f2, S::set(0.2222222222222222));
+	p = S::fma(p, f2, S::set(0.2857142857142857));
+
+	V w_hi = S::mul(f2, S::set(TWO_FIFTHS_HI));
+	V w_lo = S::add(S::fms(f2, S::set(TWO_FIFTHS_HI), w_hi),
+		S::fma(f2, S::set(TWO_FIFTHS_LO), S::mul(f2_lo, S::set(TWO_FIFTHS_HI))));
+	V i_hi, i_lo;
+	twoSum<S>(S::set(TWO_THIRDS_HI), w_hi, i_hi, i_lo);
+	i_lo = S::add(i_lo, S::add(S::set(TWO_THIRDS_LO), S::fma(S::mul(f2, f2), p, w_lo)));
+
+	V t_hi = S::mul(f3, i_hi);
+	V t_lo = S::add(S::fms(f3, i_hi, t_hi), S::fma(f3, i_lo, S::mul(f3_lo, i_hi)));
+
+	// ln(x) = e * ln(2) + 2 f + T
+	V s_hi, s_lo, l_hi, l_lo;
+	twoSum<S>(S::mul(e, S::set(LN2_HI)), S::add(f_hi, f_hi), s_hi, s_lo);
+	twoSum<S>(s_hi, t_hi, l_hi, l_lo);
+	l_lo = S::add(S::add(l_lo, s_lo),
+		S::fma(e, S::set(LN2_LO), S::add(S::add(f_lo, f_lo), t_lo)));
+	fastTwoSum<S>(l_hi, l_lo, l_hi, l_lo);
+
+	// z = y * ln(x)
+	V z_hi = S::mul(y, l_hi);
+	V z_lo = S::fma(y, l_lo, S::fms(y, l_hi, z_hi));
+	fastTwoSum<S>(z_hi, z_lo, z_hi, z_lo);
+	ok = S::andm(ok, S::andm(S::ge(z_hi, S::set(Z_MIN)), S::le(z_hi, S::set(Z_MAX))));
+
+	// exp(z) = 2^k * exp(r)
+	V k = S::round(S::mul(z_hi, S::set(INV_LN2)));
+	V r_hi = S::fnma(k, S::set(LN2_HI), z_hi); // exact
+	V r_lo = S::fnma(k, S::set(LN2_LO), z_lo);
+	twoSum<S>(r_hi, r_lo, r_hi, r_lo);
+
+	V q = S::set(7.647163731819816e-13);
+	q = S::fma(q, r_hi, S::set(1.1470745597729725e-11));
+	q = S::fma(q, r_hi, S::set(1.6059043836821613e-10));
+	q = S::fma(q, r_hi, S::set(2.08767569878681e-09));
+	q = S::fma(q, r_hi, S::set(2.505210838544172e-08));
+	q = S::fma(q, r_hi, S::set(2.755731922398589e-07));
+	q = S::fma(q, r_hi, S::set(2.7557319223985893e-06));
+	q = S::fma(q, r_hi, S::set(2.48015873015873e-05));
+	q = S::fma(q, r_hi, S::set(0.0001984126984126984));
+	q = S::fma(q, r_hi, S::set(0.001388888888888889));
+	q = S::fma(q, r_hi, S::set(0.008333333333333333));
+	q = S::fma(q, r_hi, S::set(0.041666666666666664));
+	q = S::fma(q, r_hi, S::set(0.16666666666666666));
+	q = S::fma(q, r_hi, S::set(0.5));
+
+	V h, h_lo;
+	fastTwoSum<S>(one, r_hi, h, h_lo);
+	V low = S::fma(S::mul(r_hi, r_hi), q, S::fma(r_lo, r_hi, S::add(r_lo, h_lo)));
+	V res = S::add(h, low);
+
+	// 2^k from the exponent field, k + 1023 lands in the low bits of the 1.5 * 2^52 magic number
+	I kbits = S::addi(S::asInt(S::add(k, S::set(6755399441055744.0))), S::seti(1023));
+	out = S::mul(res, S::asDouble(S::template slli<52>(kbits)));
+
+	return S::bits(ok);
+}
+
+template <class S>
+void powArray(const double* a, const double* b, double* c, size_t n)
+{
+	size_t i = 0;
+	for (; i + S::width <= n; i += S::width)
+	{
+		typename S::V r;
+		unsigned ok = powLanes<S>(S::load(a + i), S::load(b + i), r);
+		S::store(c + i, r);
+		if (ok != S::full)
+		{
+			for (size_t j = 0; j < S::width; ++j)
+			{
+				if (!(ok & (1u << j)))
+					c[i + j] = std::pow(a[i + j], b[i + j]);
+			}
+		}
+	}
+	for (; i < n; ++i)
+		c[i] = std::pow(a[i], b[i]);
+}
+
+} // namespace simd_pow
+} // namespace
+
+#endif // HOST_POW_SIMD_H
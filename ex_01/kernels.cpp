@@ -0,0 +1,899 @@
+#include "kernels.h"
+
+// CL program source
+const std::string kernel1{ R"KS1(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#else
+#  error double precision is not supported
+#endif
+kernel
+void entry_point(ulong n, global const double *a,
+        global const double *b, global double *c)
+{
+    size_t id = get_global_id(0);
+    if (id < n)
+       c[id] =  pow(a[id], b[id]);
+}
+)KS1" };
+
+// kernel1 with the launch geometry as build options: VEC elements per vector (1, 2, 4, 8) and
+// EPT vectors per work-item. Vectors are strided by the global size, so neighbouring
+// work-items touch neighbouring memory; the n % VEC tail is done by the first work-items.
+// A_SCALAR / B_SCALAR turn the operand into a double argument broadcast to every element.
+// Integral exponents have two faster paths: POW_INT=<n> compiles the exponent in (a multiply
+// chain up to |n| = 4, pown beyond), B_INT takes pown with the exponents converted to int.
+// Otherwise POW_FN=<builtin> replaces pow, or POW_FLOAT=<builtin> for float-only builtins.
+const std::string kernelTunable{ R"KS2(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#else
+#  error double precision is not supported
+#endif
+#ifndef VEC
+#  define VEC 1
+#endif
+#ifndef EPT
+#  define EPT 1
+#endif
+#define CAT_(a, b) a##b
+#define CAT(a, b) CAT_(a, b)
+
+#if VEC == 1
+#  define VTYPE double
+#  define LOADV(v, p) (p)[v]
+#  define STOREV(x, v, p) ((p)[v] = (x))
+#else
+#  define VTYPE CAT(double, VEC)
+#  define LOADV(v, p) CAT(vload, VEC)(v, p)
+#  define STOREV(x, v, p) CAT(vstore, VEC)(x, v, p)
+#endif
+
+#ifdef A_SCALAR
+#  define A_ARG double a
+#  define A_VEC(v) ((VTYPE)(a))
+#  define A_ONE(t) (a)
+#else
+#  define A_ARG global const double *a
+#  define A_VEC(v) LOADV(v, a)
+#  define A_ONE(t) a[t]
+#endif
+#ifdef B_SCALAR
+#  define B_ARG double b
+#  define B_VEC(v) ((VTYPE)(b))
+#  define B_ONE(t) (b)
+#else
+#  define B_ARG global const double *b
+#  define B_VEC(v) LOADV(v, b)
+#  define B_ONE(t) b[t]
+#endif
+
+#if VEC == 1
+#  define ITYPE int
+#  define CONVERT_ITYPE convert_int
+#else
+#  define ITYPE CAT(int, VEC)
+#  define CONVERT_ITYPE CAT(convert_int, VEC)
+#endif
+
+#if defined(POW_INT) && POW_INT >= -4 && POW_INT <= 4
+// Square and multiply, unrolled since the exponent is a constant. Negative exponents start
+// from 1/x, so (1/x)^|n| doesn't overflow or underflow where x^|n| would.
+#  define DEFINE_POW_CHAIN(name, T) \
+T name(T x)                                                     \
+{                                                               \
+    T r = (T)(1.0);                                             \
+    if (POW_INT < 0)                                            \
+        x = (T)(1.0) / x;                                       \
+    for (int e = POW_INT < 0 ? -POW_INT : POW_INT; e; e >>= 1)  \
+    {                                                           \
+        if (e & 1)                                              \
+            r *= x;                                             \
+        x *= x;                                                 \
+    }                                                           \
+    return r;                                                   \
+}
+DEFINE_POW_CHAIN(pow_chain, double)
+#  if VEC > 1
+DEFINE_POW_CHAIN(pow_chainv, VTYPE)
+#  else
+#    define pow_chainv pow_chain
+#  endif
+#  define POWV(x, y) pow_chainv(x)
+#  define POW1(x, y) pow_chain(x)
+#elif defined(POW_INT)
+#  define POWV(x, y) pown(x, (ITYPE)(POW_INT))
+#  define POW1(x, y) pown(x, POW_INT)
+#elif defined(B_INT)
+#  define POWV(x, y) pown(x, CONVERT_ITYPE(y))
+#  define POW1(x, y) pown(x, convert_int(y))
+#elif defined(POW_FLOAT)
+// Single precision builtin (native_powr, half_powr) on the values converted to float
+#  if VEC == 1
+#    define POWV(x, y) convert_double(POW_FLOAT(convert_float(x), convert_float(y)))
+#  else
+#    define POWV(x, y) CAT(convert_double, VEC)(POW_FLOAT(CAT(convert_float, VEC)(x), CAT(convert_float, VEC)(y)))
+#  endif
+#  define POW1(x, y) convert_double(POW_FLOAT(convert_float(x), convert_float(y)))
+#else
+#  ifndef POW_FN
+#    define POW_FN pow
+#  endif
+#  define POWV(x, y) POW_FN(x, y)
+#  define POW1(x, y) POW_FN(x, y)
+#endif
+
+kernel
+void entry_point(ulong n, A_ARG, B_ARG, global double *c)
+{
+    size_t id = get_global_id(0);
+    size_t stride = get_global_size(0);
+    ulong vectors = n / VEC;
+
+    for (uint k = 0; k < EPT; ++k)
+    {
+        ulong v = id + (ulong)k * stride;
+        if (v < vectors)
+            STOREV(POWV(A_VEC(v), B_VEC(v)), v, c);
+    }
+
+#if VEC > 1
+    ulong t = vectors * VEC + id;
+    if (t < n)
+        c[t] = POW1(A_ONE(t), B_ONE(t));
+#endif
+}
+)KS2" };
+
+// Sets *notIntegral when an exponent isn't an integer that fits an int (NaN and inf included)
+const std::string kernelIntegralScan{ R"KS3(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#else
+#  error double precision is not supported
+#endif
+kernel
+void integral_scan(ulong n, global const double *b, global int *notIntegral)
+{
+    size_t id = get_global_id(0);
+    if (id < n)
+    {
+        double y = b[id];
+        if (!(y == rint(y) && fabs(y) <= 2147483647.0))
+            *notIntegral = 1;
+    }
+}
+)KS3" };
+
+// pow for devices without double precision, on host values converted to float.
+// FLOAT: plain single precision. DOUBLE_FLOAT: every value is an unevaluated (hi, lo) float pair
+// carrying about 44 bits, with log and exp evaluated in that format. B_SCALAR as above.
+// Must not be built with -cl-fast-relaxed-math or -cl-unsafe-math-optimizations: the error
+// terms of the pair arithmetic only survive exact IEEE evaluation order.
+const std::string kernelReduced{ R"KS4(
+#define DF(h, l) ((float2)((h), (l)))
+// a + b = s + e exactly
+float2 df_two_sum(float a, float b)
+{
+    float s = a + b;
+    float bb = s - a;
+    return DF(s, (a - (s - bb)) + (b - bb));
+}
+
+// Same for |a| >= |b|
+float2 df_quick_two_sum(float a, float b)
+{
+    float s = a + b;
+    return DF(s, b - (s - a));
+}
+
+// a * b = p + e exactly
+float2 df_two_prod(float a, float b)
+{
+    float p = a * b;
+#ifdef FP_FAST_FMAF
+    return DF(p, fma(a, b, -p));
+#else
+    // Dekker's product with Veltkamp splits
+    float t = 4097.0f * a;
+    float ah = t - (t - a), al = a - ah;
+    t = 4097.0f * b;
+    float bh = t - (t - b), bl = b - bh;
+    return DF(p, ((ah * bh - p) + ah * bl + al * bh) + al * bl);
+#endif
+}
+
+float2 df_add(float2 a, float2 b)
+{
+    float2 s = df_two_sum(a.x, b.x);
+    float2 t = df_two_sum(a.y, b.y);
+    s = df_quick_two_sum(s.x, s.y + t.x);
+    return df_quick_two_sum(s.x, s.y + t.y);
+}
+
+float2 df_mul(float2 a, float2 b)
+{
+    float2 p = df_two_prod(a.x, b.x);
+    return df_quick_two_sum(p.x, p.y + (a.x * b.y + a.y * b.x));
+}
+
+float2 df_mul_f(float2 a, float b)
+{
+    float2 p = df_two_prod(a.x, b);
+    return df_quick_two_sum(p.x, p.y + a.y * b);
+}
+
+float2 df_ldexp(float2 a, int k)
+{
+    return DF(ldexp(a.x, k), ldexp(a.y, k));
+}
+
+// exp(a) = 2^k * (1 + s)^256, s = expm1(r / 256), r = a - k ln(2)
+float2 df_exp(float2 a)
+{
+    if (a.x > 88.7f)
+        return DF(INFINITY, 0.0f);
+    if (a.x < -103.9f)
+        return DF(0.0f, 0.0f);
+
+    const float2 LN2 = DF(0.693147182f, -1.90465421e-09f);
+    const float2 ONE_SIXTH = DF(0.166666672f, -4.96705388e-09f);
+    float k = rint(a.x * 1.44269502f);
+    float2 r = df_add(a, df_mul_f(-LN2, k));
+    r = DF(r.x * (1.0f / 256.0f), r.y * (1.0f / 256.0f));
+
+    // Taylor series of expm1, |r| < 0.0014; the small high order terms are plain floats
+    float p = (1.0f / 24.0f) + r.x * ((1.0f / 120.0f) + r.x * (1.0f / 720.0f));
+    float2 t = df_add(ONE_SIXTH, df_mul_f(r, p));
+    t = df_add(DF(0.5f, 0.0f), df_mul(r, t));
+    t = df_add(DF(1.0f, 0.0f), df_mul(r, t));
+    float2 s = df_mul(r, t);
+
+    // expm1(2x) = expm1(x) * (2 + expm1(x)), keeps the small s exact while squaring
+    for (int i = 0; i < 8; ++i)
+        s = df_mul(s, df_add(DF(2.0f, 0.0f), s));
+
+    return df_ldexp(df_add(DF(1.0f, 0.0f), s), (int)k);
+}
+
+// log(a) for a > 0: one Newton step x + a exp(-x) - 1 from the float log doubles its bits
+float2 df_log(float2 a)
+{
+    float2 x = DF(log(a.x), 0.0f);
+    float2 e = df_mul(a, df_exp(-x));
+    return df_add(x, df_add(e, DF(-1.0f, 0.0f)));
+}
+
+float2 df_pow(float2 a, float2 b)
+{
+    // Zeros, infinities and NaNs behave as the float pow of the high parts
+    if (a.x == 0.0f || !isfinite(a.x) || !isfinite(b.x))
+        return DF(pow(a.x, b.x), 0.0f);
+    if (b.x == 0.0f || (a.x == 1.0f && a.y == 0.0f))
+        return DF(1.0f, 0.0f);
+
+    float sign = 1.0f;
+    if (a.x < 0.0f)
+    {
+        // Negative bases only have integral powers, odd ones keep the sign
+        if (rint(b.x) != b.x || rint(b.y) != b.y)
+            return DF(NAN, 0.0f);
+        if (fabs(fmod(b.x, 2.0f) + fmod(b.y, 2.0f)) == 1.0f)
+            sign = -1.0f;
+        a = -a;
+    }
+
+    float2 r = df_exp(df_mul(b, df_log(a)));
+    return DF(sign * r.x, sign * r.y);
+}
+#ifdef DOUBLE_FLOAT
+#  define REAL float2
+#  define POW(x, y) df_pow(x, y)
+#else
+#  define REAL float
+#  define POW(x, y) pow(x, y)
+#endif
+#ifdef B_SCALAR
+#  define B_ARG REAL b
+#  define B_AT(i) (b)
+#else
+#  define B_ARG global const REAL *b
+#  define B_AT(i) b[i]
+#endif
+
+kernel
+void entry_point(ulong n, global const REAL *a, B_ARG, global REAL *c)
+{
+    size_t id = get_global_id(0);
+    if (id < n)
+        c[id] = POW(a[id], B_AT(id));
+}
+)KS4" };
+
+// pow with packed storage and wide compute: a, b and c are held as STORAGE_HALF (through
+// vload_half / vstore_half_rte, which need no cl_khr_fp16) or STORAGE_FLOAT, doubles otherwise.
+// The arithmetic is in double with COMPUTE_DOUBLE, in float otherwise; results are rounded once
+// to the storage format. B_SCALAR passes b as one argument of the compute type.
+const std::string kernelStorage{ R"KS5(
+#ifdef COMPUTE_DOUBLE
+#  if defined(cl_khr_fp64)
+#    pragma OPENCL EXTENSION cl_khr_fp64: enable
+#  elif defined(cl_amd_fp64)
+#    pragma OPENCL EXTENSION cl_amd_fp64: enable
+#  else
+#    error double precision is not supported
+#  endif
+#  define WIDE double
+#else
+#  define WIDE float
+#endif
+#if defined(STORAGE_HALF)
+#  define STORED half
+#  define LOAD(p, i) ((WIDE)vload_half(i, p))
+#  define STORE(v, i, p) vstore_half_rte(v, i, p)
+#elif defined(STORAGE_FLOAT)
+#  define STORED float
+#  define LOAD(p, i) ((WIDE)(p)[i])
+#  define STORE(v, i, p) ((p)[i] = (float)(v))
+#else
+#  define STORED double
+#  define LOAD(p, i) ((WIDE)(p)[i])
+#  define STORE(v, i, p) ((p)[i] = (v))
+#endif
+#ifdef B_SCALAR
+#  define B_ARG WIDE b
+#  define B_AT(i) (b)
+#else
+#  define B_ARG global const STORED *b
+#  define B_AT(i) LOAD(b, i)
+#endif
+
+kernel
+void entry_point(ulong n, global const STORED *a, B_ARG, global STORED *c)
+{
+    size_t id = get_global_id(0);
+    if (id < n)
+        STORE(pow(LOAD(a, id), B_AT(id)), id, c);
+}
+)KS5" };
+
+// Work-group reduction of T (built with -DT=<type>) for OP_SUM, OP_MIN, OP_MAX or OP_ARGMIN.
+// Work-group g reduces a strided share of segment g / groups, [segment * s, segment * (s + 1)),
+// to out[g], with the smallest element index among equal minima in outIndex[g] for OP_ARGMIN;
+// a second run over those partials with one group per segment finishes. INDEX_IN takes the
+// indices from inIndex rather than the position. The local arrays hold one value per
+// work-item and the work-group size is a power of two. USE_SUBGROUPS (cl_intel_subgroups, or
+// cl_khr_subgroups with OpenCL C 2.0) reduces in sub-groups first and only their results
+// through local memory.
+const std::string kernelReduce{ R"KS6(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#endif
+#if defined(USE_SUBGROUPS) && defined(cl_intel_subgroups)
+#  pragma OPENCL EXTENSION cl_intel_subgroups: enable
+#elif defined(USE_SUBGROUPS)
+#  pragma OPENCL EXTENSION cl_khr_subgroups: enable
+#endif
+#define NO_INDEX ((ulong)-1)
+
+#if defined(OP_SUM)
+#  define COMBINE(x, y) ((x) + (y))
+#  define SUB_GROUP_REDUCE(x) sub_group_reduce_add(x)
+#elif defined(OP_MAX)
+#  define COMBINE(x, y) max(x, y)
+#  define SUB_GROUP_REDUCE(x) sub_group_reduce_max(x)
+#else
+#  define COMBINE(x, y) min(x, y)
+#  define SUB_GROUP_REDUCE(x) sub_group_reduce_min(x)
+#endif
+
+#ifdef OP_ARGMIN
+// (v, i) takes (w, j) when w is smaller, or equal at a lower index
+#  define UPDATE(v, i, w, j) if ((w) < (v) || ((w) == (v) && (j) < (i))) { v = (w); i = (j); }
+#  define SET_INDEX(k, x) li[k] = (x)
+#  define INDEX_AT(k) li[k]
+#else
+#  define UPDATE(v, i, w, j) v = COMBINE(v, w)
+#  define SET_INDEX(k, x)
+#  define INDEX_AT(k) NO_INDEX
+#endif
+#ifdef INDEX_IN
+#  define SOURCE_INDEX(k) inIndex[k]
+#else
+#  define SOURCE_INDEX(k) (k)
+#endif
+
+#ifdef USE_SUBGROUPS
+// Reduce (v, i) over the sub-group, every work-item gets the result
+#  ifdef OP_ARGMIN
+#    define REDUCE_SUB_GROUP(v, i) { T m = sub_group_reduce_min(v); i = sub_group_reduce_min((v) == m ? (i) : NO_INDEX); v = m; }
+#  else
+#    define REDUCE_SUB_GROUP(v, i) v = SUB_GROUP_REDUCE(v)
+#  endif
+#endif
+
+kernel
+void reduce(ulong n, ulong segment, uint groups, T identity,
+        global const T *in, global const ulong *inIndex,
+        global T *out, global ulong *outIndex,
+        local T *lv, local ulong *li)
+{
+    size_t lid = get_local_id(0);
+    size_t local_size = get_local_size(0);
+    size_t g = get_group_id(0);
+    ulong first = (g / groups) * segment;
+    ulong last = min(first + segment, n);
+
+    T v = identity;
+    ulong i = NO_INDEX;
+    for (ulong k = first + (g % groups) * local_size + lid; k < last; k += (ulong)groups * local_size)
+    {
+        T w = in[k];
+        UPDATE(v, i, w, SOURCE_INDEX(k));
+    }
+
+#ifdef USE_SUBGROUPS
+    REDUCE_SUB_GROUP(v, i);
+    uint sg = get_sub_group_id();
+    if (get_sub_group_local_id() == 0)
+    {
+        lv[sg] = v;
+        SET_INDEX(sg, i);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (sg == 0)
+    {
+        v = identity;
+        i = NO_INDEX;
+        for (uint k = get_sub_group_local_id(); k < get_num_sub_groups(); k += get_sub_group_size())
+        {
+            T w = lv[k];
+            UPDATE(v, i, w, INDEX_AT(k));
+        }
+        REDUCE_SUB_GROUP(v, i);
+    }
+#else
+    lv[lid] = v;
+    SET_INDEX(lid, i);
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (size_t half = local_size / 2; half > 0; half >>= 1)
+    {
+        if (lid < half)
+        {
+            T w = lv[lid + half];
+            UPDATE(v, i, w, INDEX_AT(lid + half));
+            lv[lid] = v;
+            SET_INDEX(lid, i);
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+#endif
+
+    if (lid == 0)
+    {
+        out[g] = v;
+#ifdef OP_ARGMIN
+        outIndex[g] = i;
+#endif
+    }
+}
+)KS6" };
+
+// Prefix sums of T, a level of a multi-level block scan. scan_blocks: each work-group scans
+// ITEMS consecutive elements per work-item, the work-item totals through local memory, and
+// leaves its block total in blockSums; inclusive or exclusive. add_offsets adds the scanned
+// block totals of the level above. Every element is read and written by the same work-item,
+// so in and out may be the same buffer.
+// Compaction counts instead of summing: with KEEP_FINITE (drop NaN and infinities) and/or
+// KEEP_ABOVE (values above the threshold argument), or KEEP_ALL, the input is IN_T and
+// element i counts 1 when kept; compact_scatter then moves the kept elements to their
+// inclusive scan position - 1.
+const std::string kernelScan{ R"KS7(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#endif
+#ifndef IN_T
+#  define IN_T T
+#endif
+#define ITEMS 4
+
+#if defined(KEEP_FINITE) && defined(KEEP_ABOVE)
+#  define KEEP(x) (isfinite(x) && (x) > threshold)
+#elif defined(KEEP_FINITE)
+#  define KEEP(x) isfinite(x)
+#elif defined(KEEP_ABOVE)
+#  define KEEP(x) ((x) > threshold)
+#elif defined(KEEP_ALL)
+#  define KEEP(x) 1
+#endif
+#ifdef KEEP
+#  define MAP(x) (KEEP(x) ? (T)1 : (T)0)
+#else
+#  define MAP(x) (x)
+#endif
+
+kernel
+void scan_blocks(ulong n, global const IN_T *in, global T *out, global T *blockSums,
+        IN_T threshold, uint inclusive, local T *totals)
+{
+    size_t lid = get_local_id(0);
+    size_t local_size = get_local_size(0);
+    ulong first = get_global_id(0) * ITEMS;
+
+    // Scan of the work-item's own elements
+    T prefix[ITEMS];
+    T sum = 0;
+    for (uint k = 0; k < ITEMS; ++k)
+    {
+        T x = first + k < n ? MAP(in[first + k]) : 0;
+        prefix[k] = inclusive ? sum + x : sum;
+        sum += x;
+    }
+
+    // Inclusive scan of the work-item totals (Hillis-Steele)
+    totals[lid] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (size_t offset = 1; offset < local_size; offset <<= 1)
+    {
+        T t = lid >= offset ? totals[lid - offset] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        totals[lid] += t;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    T before = lid ? totals[lid - 1] : 0;
+    for (uint k = 0; k < ITEMS; ++k)
+    {
+        if (first + k < n)
+            out[first + k] = before + prefix[k];
+    }
+    if (lid == local_size - 1)
+        blockSums[get_group_id(0)] = totals[lid];
+}
+
+kernel
+void add_offsets(ulong n, ulong block, global T *out, global const T *offsets)
+{
+    size_t i = get_global_id(0);
+    if (i < n && i >= block)
+        out[i] += offsets[i / block];
+}
+
+#ifdef KEEP
+kernel
+void compact_scatter(ulong n, global const IN_T *in, global const T *positions, IN_T threshold,
+        global IN_T *out, global ulong *indices)
+{
+    size_t i = get_global_id(0);
+    if (i < n)
+    {
+        IN_T x = in[i];
+        if (KEEP(x))
+        {
+            T at = positions[i] - 1;
+            out[at] = x;
+            if (indices)
+                indices[at] = i;
+        }
+    }
+}
+#endif
+)KS7" };
+
+// One pass of an LSD radix sort of KEY (uint or ulong, KEY_BITS wide) on the 4-bit digit at
+// 'shift'. Work-items own ITEMS consecutive keys and count their digits in local memory
+// (counts[digit * local size + item]). radix_count leaves the totals of every work-group digit
+// major in 'histogram', whose exclusive scan gives each (digit, group) its first position;
+// radix_scatter ranks the tile's keys from the local counts and moves them (and VALUE
+// payloads) there. Ranks follow (digit, item, order within the item), so every pass is stable.
+// radix_encode / radix_decode map KEY_FLOAT (IEEE) and KEY_SIGNED bits to and from unsigned
+// integers in the same order. Float NaNs of either sign become the positive quiet NaN first,
+// which sorts after +infinity.
+const std::string kernelRadixSort{ R"KS8(
+#define RADIX 16
+#define ITEMS 4
+#define DIGIT(k, shift) ((uint)((k) >> (shift)) & (RADIX - 1))
+#define SIGN ((KEY)1 << (KEY_BITS - 1))
+
+#if defined(KEY_FLOAT) && KEY_BITS == 32
+#  define INF_BITS 0x7F800000u
+#  define QNAN_BITS 0x7FC00000u
+#elif defined(KEY_FLOAT)
+#  define INF_BITS 0x7FF0000000000000ul
+#  define QNAN_BITS 0x7FF8000000000000ul
+#endif
+
+#if defined(KEY_FLOAT)
+#  define CANONICAL(k) (((k) & ~SIGN) > INF_BITS ? (KEY)QNAN_BITS : (k))
+#  define ENCODE(k) ((CANONICAL(k) & SIGN) ? ~CANONICAL(k) : CANONICAL(k) | SIGN)
+#  define DECODE(k) (((k) & SIGN) ? (k) & ~SIGN : ~(k))
+#elif defined(KEY_SIGNED)
+#  define ENCODE(k) ((k) ^ SIGN)
+#  define DECODE(k) ((k) ^ SIGN)
+#else
+#  define ENCODE(k) (k)
+#  define DECODE(k) (k)
+#endif
+
+kernel
+void radix_encode(ulong n, global KEY *keys)
+{
+    size_t i = get_global_id(0);
+    if (i < n)
+    {
+        KEY k = keys[i];
+        keys[i] = ENCODE(k);
+    }
+}
+
+kernel
+void radix_decode(ulong n, global KEY *keys)
+{
+    size_t i = get_global_id(0);
+    if (i < n)
+        keys[i] = DECODE(keys[i]);
+}
+
+void count_digits(ulong n, global const KEY *keys, uint shift, local uint *counts)
+{
+    size_t lid = get_local_id(0);
+    size_t local_size = get_local_size(0);
+    ulong first = get_global_id(0) * ITEMS;
+
+    for (uint d = 0; d < RADIX; ++d)
+        counts[d * local_size + lid] = 0;
+    for (uint k = 0; k < ITEMS; ++k)
+    {
+        if (first + k < n)
+            ++counts[DIGIT(keys[first + k], shift) * local_size + lid];
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+kernel
+void radix_count(ulong n, global const KEY *keys, uint shift, global uint *histogram, local uint *counts)
+{
+    count_digits(n, keys, shift, counts);
+
+    size_t lid = get_local_id(0);
+    size_t local_size = get_local_size(0);
+    if (lid < RADIX)
+    {
+        uint sum = 0;
+        for (size_t l = 0; l < local_size; ++l)
+            sum += counts[lid * local_size + l];
+        histogram[lid * get_num_groups(0) + get_group_id(0)] = sum;
+    }
+}
+
+kernel
+void radix_scatter(ulong n, global const KEY *keys, global KEY *sorted,
+#ifdef VALUE
+        global const VALUE *values, global VALUE *sortedValues,
+#endif
+        uint shift, global const uint *offsets, local uint *counts, local uint *totals)
+{
+    local uint starts[RADIX];
+    count_digits(n, keys, shift, counts);
+
+    size_t lid = get_local_id(0);
+    size_t local_size = get_local_size(0);
+
+    // Exclusive scan of all the counts in digit major order: RADIX consecutive entries per
+    // work-item, then the work-item totals (Hillis-Steele)
+    uint sum = 0;
+    for (uint j = 0; j < RADIX; ++j)
+    {
+        uint c = counts[lid * RADIX + j];
+        counts[lid * RADIX + j] = sum;
+        sum += c;
+    }
+    totals[lid] = sum;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (size_t offset = 1; offset < local_size; offset <<= 1)
+    {
+        uint t = lid >= offset ? totals[lid - offset] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        totals[lid] += t;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    uint before = lid ? totals[lid - 1] : 0;
+    for (uint j = 0; j < RADIX; ++j)
+        counts[lid * RADIX + j] += before;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (lid < RADIX)
+        starts[lid] = counts[lid * local_size];
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Rank within the digit in the tile, plus the first position of the digit for this group
+    size_t groups = get_num_groups(0);
+    size_t g = get_group_id(0);
+    ulong first = get_global_id(0) * ITEMS;
+    for (uint k = 0; k < ITEMS; ++k)
+    {
+        if (first + k < n)
+        {
+            KEY key = keys[first + k];
+            uint d = DIGIT(key, shift);
+            uint at = offsets[d * groups + g] + counts[d * local_size + lid]++ - starts[d];
+            sorted[at] = key;
+#ifdef VALUE
+            sortedValues[at] = values[first + k];
+#endif
+        }
+    }
+}
+)KS8" };
+
+// Comparison of n doubles with EXPECTED(i), an element expression over the EXPECTED_PARAMS
+// (both defined ahead of this source, see validation.cpp), into one summary per work-group:
+// largest absolute and relative error over pairs of finite values, sum of the element hashes,
+// NaN and infinity counts among the values, and a histogram of the ULP distances by power of
+// two. Work-items keep their counts private and add them to local memory once at the end; the
+// work-group size is a power of two. Group g writes SUMMARY ulongs from summary[g * SUMMARY]:
+// the bits of the two errors, the hash, the two counts and the BUCKETS buckets.
+const std::string kernelValidate{ R"KS9(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#endif
+#define BUCKETS 16
+#define SUMMARY (5 + BUCKETS)
+// counts[]: NaNs, infinities, then the buckets
+#define NANS 0
+#define INFINITIES 1
+
+// Bit patterns on a monotonic integer line, -0 and +0 meet at zero (as ulpDistance() in utils.h)
+long ordered(double x)
+{
+    long b = as_long(x);
+    return b < 0 ? LONG_MIN - b : b;
+}
+
+// Position dependent element hash, summed to the content hash (as contentHash() in validation.cpp)
+ulong element_hash(double x, ulong i)
+{
+    ulong z = as_ulong(x) ^ (i * 0x9e3779b97f4a7c15UL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+    return z ^ (z >> 31);
+}
+
+kernel
+void validate(ulong n, global const double *values, global ulong *summary,
+        local double *abs_err, local double *rel_err, local ulong *hashes, local uint *counts EXPECTED_PARAMS)
+{
+    size_t lid = get_local_id(0);
+    size_t local_size = get_local_size(0);
+    for (size_t k = lid; k < BUCKETS + 2; k += local_size)
+        counts[k] = 0;
+
+    double max_abs = 0.0, max_rel = 0.0;
+    ulong hash = 0;
+    uint own[BUCKETS + 2];
+    for (uint k = 0; k < BUCKETS + 2; ++k)
+        own[k] = 0;
+
+    for (ulong i = get_global_id(0); i < n; i += get_global_size(0))
+    {
+        double v = values[i];
+        double e = EXPECTED(i);
+        hash += element_hash(v, i);
+        own[NANS] += isnan(v) ? 1 : 0;
+        own[INFINITIES] += isinf(v) ? 1 : 0;
+
+        uint bucket;
+        if (isnan(v) || isnan(e))
+            bucket = isnan(v) && isnan(e) ? 0 : BUCKETS - 1;
+        else if (isinf(v) || isinf(e))
+            bucket = v == e ? 0 : BUCKETS - 1;
+        else
+        {
+            double d = fabs(v - e);
+            max_abs = fmax(max_abs, d);
+            max_rel = fmax(max_rel, e != 0.0 ? d / fabs(e) : (d != 0.0 ? INFINITY : 0.0));
+            long a = ordered(v), b = ordered(e);
+            ulong ulps = a > b ? (ulong)a - (ulong)b : (ulong)b - (ulong)a;
+            bucket = ulps ? min((uint)(64 - clz(ulps)), (uint)(BUCKETS - 1)) : 0;
+        }
+        ++own[2 + bucket];
+    }
+
+    abs_err[lid] = max_abs;
+    rel_err[lid] = max_rel;
+    hashes[lid] = hash;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (uint k = 0; k < BUCKETS + 2; ++k)
+    {
+        if (own[k])
+            atomic_add(&counts[k], own[k]);
+    }
+    for (size_t s = local_size / 2; s > 0; s >>= 1)
+    {
+        if (lid < s)
+        {
+            abs_err[lid] = fmax(abs_err[lid], abs_err[lid + s]);
+            rel_err[lid] = fmax(rel_err[lid], rel_err[lid + s]);
+            hashes[lid] += hashes[lid + s];
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    global ulong *out = summary + get_group_id(0) * SUMMARY;
+    if (lid == 0)
+    {
+        out[0] = as_ulong(abs_err[0]);
+        out[1] = as_ulong(rel_err[0]);
+        out[2] = hashes[0];
+    }
+    for (size_t k = lid; k < BUCKETS + 2; k += local_size)
+        out[3 + k] = counts[k];
+}
+)KS9" };
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3"): block p of the sequence is the counter (p, 0) encrypted with the 64-bit seed as
+// key, four 32-bit words making two doubles of 53 bits in [0, 1). "philox_fill" writes elements
+// [first, first + n) of the sequence, work-item p the pair 2p, 2p + 1: uniform in [a, b), or with
+// NORMAL a Box-Muller pair of mean a and standard deviation b. Contraction is off so the
+// uniform values match the host implementation in random.cpp bit for bit.
+const std::string kernelRandom{ R"KS10(
+#if defined(cl_khr_fp64)
+#  pragma OPENCL EXTENSION cl_khr_fp64: enable
+#elif defined(cl_amd_fp64)
+#  pragma OPENCL EXTENSION cl_amd_fp64: enable
+#endif
+#pragma OPENCL FP_CONTRACT OFF
+#define TWO_PI 6.283185307179586476925
+
+uint4 philox4x32_10(uint4 c, uint2 k)
+{
+    for (uint round = 0; round < 10; ++round)
+    {
+        if (round)
+            k += (uint2)(0x9e3779b9u, 0xbb67ae85u);
+        uint hi0 = mul_hi(0xd2511f53u, c.x), lo0 = 0xd2511f53u * c.x;
+        uint hi1 = mul_hi(0xcd9e8d57u, c.z), lo1 = 0xcd9e8d57u * c.z;
+        c = (uint4)(hi1 ^ c.y ^ k.x, lo1, hi0 ^ c.w ^ k.y, lo0);
+    }
+    return c;
+}
+
+// The top 53 bits of (hi, lo) as a double in [0, 1)
+double unit(uint lo, uint hi)
+{
+    return (double)((((ulong)hi << 32) | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+kernel
+void philox_fill(ulong first, ulong n, global double *out, ulong seed, double a, double b)
+{
+    ulong p = first / 2 + get_global_id(0);
+    ulong i = 2 * p;
+    uint4 x = philox4x32_10((uint4)((uint)p, (uint)(p >> 32), 0, 0), (uint2)((uint)seed, (uint)(seed >> 32)));
+    double u0 = unit(x.x, x.y), u1 = unit(x.z, x.w);
+#ifdef NORMAL
+    double r = sqrt(-2.0 * log(1.0 - u0));
+    double v0 = a + b * (r * cos(TWO_PI * u1));
+    double v1 = a + b * (r * sin(TWO_PI * u1));
+#else
+    double v0 = a + (b - a) * u0;
+    double v1 = a + (b - a) * u1;
+#endif
+    if (i >= first && i < first + n)
+        out[i - first] = v0;
+    if (i + 1 >= first && i + 1 < first + n)
+        out[i + 1 - first] = v1;
+}
+)KS10" };
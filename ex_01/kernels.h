@@ -0,0 +1,41 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <string>
+
+// c[i] = pow(a[i], b[i]) in double precision, entry function "entry_point"
+extern const std::string kernel1;
+
+// Same computation and signature, built with -DVEC=<1|2|4|8> -DEPT=<vectors per work-item>;
+// see LaunchConfig for the matching global size
+extern const std::string kernelTunable;
+
+// "integral_scan" flags exponent arrays which the B_INT variant of kernelTunable can't take
+extern const std::string kernelIntegralScan;
+
+// pow(a, b) in single precision, or in double-float pairs with -DDOUBLE_FLOAT, for devices
+// without double precision; entry function "entry_point" with float or float2 buffers
+extern const std::string kernelReduced;
+
+// pow on operands stored as half (-DSTORAGE_HALF), float (-DSTORAGE_FLOAT) or double, computed
+// in double with -DCOMPUTE_DOUBLE or in float; entry function "entry_point"
+extern const std::string kernelStorage;
+
+// Work-group tree reduction "reduce" (sum, min, max, argmin), see reduction.h
+extern const std::string kernelReduce;
+
+// Multi-level block scan ("scan_blocks", "add_offsets") and compaction ("compact_scatter"),
+// see scan.h
+extern const std::string kernelScan;
+
+// Passes of an LSD radix sort ("radix_count", "radix_scatter") and key encodings, see radix_sort.h
+extern const std::string kernelRadixSort;
+
+// Comparison "validate" of doubles with an expected expression into per-group summaries, see
+// validation.h
+extern const std::string kernelValidate;
+
+// Philox4x32-10 generator "philox_fill" of uniform or (-DNORMAL) normal doubles, see random.h
+extern const std::string kernelRandom;
+
+#endif // KERNELS_H
@@ -0,0 +1,163 @@
+#include "multi_device.h"
+#include "kernels.h"
+#include "profiling.h"
+#include "program_cache.h"
+
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+
+MultiDeviceExecutor::MultiDeviceExecutor(const std::vector<cl::Device>& devices)
+{
+	if (devices.empty())
+		throw std::domain_error("No devices for the multi-device executor.");
+
+	m_context = cl::Context(devices);
+	for (auto& d : devices)
+	{
+		Lane lane;
+		lane.device = d;
+		lane.queue = cl::CommandQueue(m_context, d, CL_QUEUE_PROFILING_ENABLE);
+		lane.kernel = cl::Kernel(buildCL_Program(m_context, d, kernel1), "entry_point");
+		// Peak rate estimate until there is a measurement
+		lane.weight = static_cast<double>(d.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>())
+			* std::max<cl_uint>(1, d.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>());
+		lane.measured = false;
+		lane.count = 0;
+		lane.ms = 0.0;
+		m_lanes.push_back(lane);
+	}
+}
+
+std::vector<double> MultiDeviceExecutor::shares() const
+{
+	double total = 0.0;
+	for (auto& l : m_lanes)
+		total += l.weight;
+
+	std::vector<double> s;
+	for (auto& l : m_lanes)
+		s.push_back(total > 0.0 ? l.weight / total : 1.0 / m_lanes.size());
+	return s;
+}
+
+void MultiDeviceExecutor::run(const double* a, const double* b, double* c, size_t n, Profiler* profiler)
+{
+	if (!n)
+		return;
+
+	// Contiguous shares, the last lane takes the rounding remainder
+	std::vector<double> share = shares();
+	std::vector<size_t> offsets(m_lanes.size() + 1, 0);
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		size_t count = (i + 1 == m_lanes.size()) ? n - offsets[i]
+			: std::min(n - offsets[i], static_cast<size_t>(share[i] * n));
+		offsets[i + 1] = offsets[i] + count;
+	}
+
+	struct Job
+	{
+		cl::Buffer A, B, C;
+		cl::Event first, second, computed, last;
+	};
+	std::vector<Job> jobs(m_lanes.size());
+
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		Lane& lane = m_lanes[i];
+		Job& job = jobs[i];
+		const size_t offset = offsets[i];
+		const size_t count = offsets[i + 1] - offset;
+		lane.count = count;
+		if (!count)
+			continue;
+
+		const size_t bytes = count * sizeof(double);
+		job.A = cl::Buffer(m_context, CL_MEM_READ_ONLY, bytes);
+		job.B = cl::Buffer(m_context, CL_MEM_READ_ONLY, bytes);
+		job.C = cl::Buffer(m_context, CL_MEM_WRITE_ONLY, bytes);
+
+		lane.queue.enqueueWriteBuffer(job.A, CL_FALSE, 0, bytes, a + offset, nullptr, &job.first);
+		lane.queue.enqueueWriteBuffer(job.B, CL_FALSE, 0, bytes, b + offset, nullptr, &job.second);
+
+		lane.kernel.setArg(0, static_cast<cl_ulong>(count));
+		lane.kernel.setArg(1, job.A);
+		lane.kernel.setArg(2, job.B);
+		lane.kernel.setArg(3, job.C);
+		lane.queue.enqueueNDRangeKernel(lane.kernel, cl::NullRange, count, cl::NullRange, nullptr, &job.computed);
+
+		lane.queue.enqueueReadBuffer(job.C, CL_FALSE, 0, bytes, c + offset, nullptr, &job.last);
+		lane.queue.flush();
+
+		if (profiler)
+		{
+			const int row = static_cast<int>(i);
+			profiler->record("write A", Profiler::Write, job.first, bytes, row);
+			profiler->record("write B", Profiler::Write, job.second, bytes, row);
+			profiler->record("entry_point", Profiler::Kernel, job.computed, count, row);
+			profiler->record("read C", Profiler::Read, job.last, bytes, row);
+		}
+	}
+
+	// Every device runs concurrently, collect them and measure each one's rate
+	std::vector<double> rate(m_lanes.size(), 0.0);
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		Lane& lane = m_lanes[i];
+		if (!lane.count)
+		{
+			lane.ms = 0.0;
+			continue;
+		}
+		lane.queue.finish();
+		lane.ms = eventSpanMs(jobs[i].first, jobs[i].last);
+		if (lane.ms > 0.0)
+			rate[i] = lane.count / lane.ms;
+	}
+
+	// Refine the weights with the measured throughput, smoothed against run to run noise.
+	// A lane's first measurement replaces its peak estimate, it is on a different scale.
+	double measuredWeight = 0.0;
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		Lane& lane = m_lanes[i];
+		if (rate[i] > 0.0)
+		{
+			lane.weight = lane.measured ? 0.5 * lane.weight + 0.5 * rate[i] : rate[i];
+			lane.measured = true;
+		}
+		if (lane.measured)
+			measuredWeight += lane.weight;
+	}
+
+	// Lanes still without a measurement (no elements, or a zero event span) keep their share,
+	// carried over onto the measured scale so that weights in both units never get compared
+	double unmeasuredShare = 0.0;
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		if (!m_lanes[i].measured)
+			unmeasuredShare += share[i];
+	}
+	if (measuredWeight <= 0.0 || unmeasuredShare >= 1.0)
+		return;
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		if (!m_lanes[i].measured)
+			m_lanes[i].weight = share[i] / (1.0 - unmeasuredShare) * measuredWeight;
+	}
+}
+
+void MultiDeviceExecutor::printStats(std::ostream& os) const
+{
+	std::vector<double> share = shares();
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+	{
+		const Lane& l = m_lanes[i];
+		os << "[" << i << "] " << l.device.getInfo<CL_DEVICE_NAME>()
+			<< " || ELEMENTS: " << l.count
+			<< " || TIME: " << l.ms << " ms"
+			<< " || RATE: " << (l.ms > 0.0 ? l.count / l.ms * 1e-3 : 0.0) << " M/s"
+			<< " || NEXT_SHARE: " << share[i] << "\n";
+	}
+}
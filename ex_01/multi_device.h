@@ -0,0 +1,50 @@
+#ifndef MULTI_DEVICE_H
+#define MULTI_DEVICE_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+class Profiler;
+
+// c[i] = pow(a[i], b[i]) split across several devices of one platform.
+// Each device gets a contiguous share of the range, weighted by
+// CL_DEVICE_MAX_COMPUTE_UNITS x CL_DEVICE_MAX_CLOCK_FREQUENCY at first and by the throughput
+// measured on the previous runs afterwards. Results land in the single output array.
+class MultiDeviceExecutor
+{
+public:
+	// Devices of one platform, see getCL_ComputeDevices(). On a CPU-only machine pass pocl
+	// sub-devices, or several pocl CPU devices with POCL_DEVICES="pthread pthread".
+	explicit MultiDeviceExecutor(const std::vector<cl::Device>& devices);
+
+	// The transfers and kernels are recorded to 'profiler', if given, one trace row per device
+	void run(const double* a, const double* b, double* c, size_t n, Profiler* profiler = nullptr);
+
+	size_t deviceCount() const { return m_lanes.size(); }
+
+	// Share of the range for every device on the next run, sums to 1
+	std::vector<double> shares() const;
+
+	// Per device share, elements and throughput of the last run
+	void printStats(std::ostream& os) const;
+
+private:
+	struct Lane
+	{
+		cl::Device device;
+		cl::CommandQueue queue;
+		cl::Kernel kernel;
+		double weight;     // relative speed estimate
+		bool measured;     // weight in elements per ms rather than the peak rate estimate
+		size_t count;      // elements of the last run
+		double ms;         // device time of the last run
+	};
+
+	cl::Context m_context;
+	std::vector<Lane> m_lanes;
+};
+
+#endif // MULTI_DEVICE_H
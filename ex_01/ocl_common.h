@@ -0,0 +1,13 @@
+#ifndef OCL_COMMON_H
+#define OCL_COMMON_H
+
+// cl2.hpp configuration shared by every translation unit of the example
+#define CL_HPP_ENABLE_EXCEPTIONS
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_CL_1_2_DEFAULT_BUILD
+#define CL_HPP_ENABLE_PROGRAM_CONSTRUCTION_FROM_ARRAY_COMPATIBILITY
+
+#include <CL/cl2.hpp>
+
+#endif // OCL_COMMON_H
@@ -0,0 +1,51 @@
+#ifndef OPERAND_H
+#define OPERAND_H
+
+#include "ocl_common.h"
+
+#include <string>
+
+// Input of an elementwise kernel: a device buffer with one value per element, or a single value
+// broadcast to every element. A scalar is passed as a kernel argument, it has no buffer and
+// nothing to transfer.
+class Operand
+{
+public:
+	Operand(const cl::Buffer& buffer)
+		: m_buffer(buffer)
+		, m_value(0.0)
+		, m_scalar(false)
+	{
+	}
+
+	Operand(double value)
+		: m_value(value)
+		, m_scalar(true)
+	{
+	}
+
+	bool isScalar() const { return m_scalar; }
+	const cl::Buffer& buffer() const { return m_buffer; }
+	double value() const { return m_value; }
+
+	void setArg(cl::Kernel& kernel, cl_uint index) const
+	{
+		if (m_scalar)
+			kernel.setArg(index, static_cast<cl_double>(m_value));
+		else
+			kernel.setArg(index, m_buffer);
+	}
+
+	// Build option selecting the kernel variant for this kind of operand 'name', e.g. " -DB_SCALAR"
+	std::string option(const char* name) const
+	{
+		return m_scalar ? std::string(" -D") + name + "_SCALAR" : std::string();
+	}
+
+private:
+	cl::Buffer m_buffer;
+	double m_value;
+	bool m_scalar;
+};
+
+#endif // OPERAND_H
@@ -0,0 +1,109 @@
+#include "packed_storage.h"
+#include "device_info.h"
+#include "host_convert.h"
+#include "kernels.h"
+#include "runtime.h"
+#include "staged_pow.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void toDevice(Storage storage, const double* src, void* dst, size_t n)
+{
+	switch (storage)
+	{
+	case Storage::Double:
+		std::memcpy(dst, src, n * sizeof(double));
+		break;
+	case Storage::Float:
+		convertToFloat(src, static_cast<float*>(dst), n);
+		break;
+	case Storage::Half:
+		convertToHalf(src, static_cast<uint16_t*>(dst), n);
+		break;
+	}
+}
+
+void fromDevice(Storage storage, const void* src, double* dst, size_t n)
+{
+	switch (storage)
+	{
+	case Storage::Double:
+		std::memcpy(dst, src, n * sizeof(double));
+		break;
+	case Storage::Float:
+		convertFromFloat(static_cast<const float*>(src), dst, n);
+		break;
+	case Storage::Half:
+		convertFromHalf(static_cast<const uint16_t*>(src), dst, n);
+		break;
+	}
+}
+
+std::string storageOptions(Storage storage, bool computeDouble)
+{
+	std::string options = computeDouble ? "-DCOMPUTE_DOUBLE" : "";
+	if (storage == Storage::Half)
+		options += " -DSTORAGE_HALF";
+	else if (storage == Storage::Float)
+		options += " -DSTORAGE_FLOAT";
+	return options;
+}
+
+} // namespace
+
+const char* toString(Storage storage)
+{
+	switch (storage)
+	{
+	case Storage::Double:
+		return "double";
+	case Storage::Float:
+		return "float";
+	case Storage::Half:
+		return "half";
+	}
+	return "";
+}
+
+size_t storageSize(Storage storage)
+{
+	switch (storage)
+	{
+	case Storage::Double:
+		return sizeof(cl_double);
+	case Storage::Float:
+		return sizeof(cl_float);
+	case Storage::Half:
+		return sizeof(cl_half);
+	}
+	return 0;
+}
+
+void powCL_Packed(Runtime& rt, Storage storage, bool computeDouble, const double* a, const double* b,
+	double exponent, double* c, size_t n, Profiler* profiler)
+{
+	if (storage == Storage::Double && !computeDouble)
+		throw std::invalid_argument("powCL_Packed() can't compute double storage in float.");
+	if (computeDouble && !hasCL_DoublePrecision(rt.device()))
+		throw std::domain_error(rt.device().getInfo<CL_DEVICE_NAME>() + " has no double precision to compute in.");
+	if (!n)
+		return;
+
+	std::string options = storageOptions(storage, computeDouble);
+	if (!b)
+		options += " -DB_SCALAR";
+	cl::Kernel kernel(rt.program(kernelStorage, options), "entry_point");
+	if (!b && computeDouble)
+		kernel.setArg(2, static_cast<cl_double>(exponent));
+	else if (!b)
+		kernel.setArg(2, static_cast<cl_float>(exponent));
+
+	powCL_Staged(rt, kernel, storageSize(storage),
+		[storage](const double* src, void* dst, size_t count) { toDevice(storage, src, dst, count); },
+		[storage](const void* src, double* dst, size_t count) { fromDevice(storage, src, dst, count); },
+		a, b, c, n, profiler, toString(storage));
+}
@@ -0,0 +1,31 @@
+#ifndef PACKED_STORAGE_H
+#define PACKED_STORAGE_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+
+class Profiler;
+class Runtime;
+
+// Format of the operands in transfer and in device memory
+enum class Storage {
+	Double,  // 8 bytes per value, exact
+	Float,   // 4 bytes, 24 bits
+	Half     // 2 bytes, 11 bits and a range of 6e-8..65504
+};
+
+const char* toString(Storage storage);
+
+// Bytes per stored value
+size_t storageSize(Storage storage);
+
+// c[i] = pow(a[i], b[i]) with kernelStorage: the host converts a and b to 'storage' (see
+// host_convert.h), the kernel computes in double when 'computeDouble' is set and in float
+// otherwise, and rounds c back to 'storage'. With a null 'b' every element is raised to
+// 'exponent', passed as a kernel argument. Double storage needs double compute. With a
+// 'profiler' the transfers and the kernel are recorded, on a profiling queue.
+void powCL_Packed(Runtime& rt, Storage storage, bool computeDouble, const double* a, const double* b,
+	double exponent, double* c, size_t n, Profiler* profiler = nullptr);
+
+#endif // PACKED_STORAGE_H
@@ -0,0 +1,84 @@
+#include "pow_engine.h"
+#include "device_info.h"
+#include "kernels.h"
+#include "runtime.h"
+#include "stream_pipeline.h"
+
+namespace {
+
+class CL_PowEngine : public PowEngine
+{
+public:
+	// Engine on the process wide runtime
+	explicit CL_PowEngine(Runtime& runtime)
+		: m_runtime(runtime)
+	{
+	}
+
+	// Engine with a runtime of its own
+	explicit CL_PowEngine(const cl::Device& device)
+		: m_owned(new Runtime(device))
+		, m_runtime(*m_owned)
+	{
+	}
+
+	std::string name() const override
+	{
+		return "OpenCL " + m_runtime.device().getInfo<CL_DEVICE_NAME>();
+	}
+
+	void pow(const double* a, const double* b, double* c, size_t n) override
+	{
+		// One chunk when it fits a single allocation, overlapped chunks otherwise
+		powCL_Stream(m_runtime.context(), m_runtime.device(), m_runtime.program(kernel1),
+			a, b, c, n, n, 2);
+	}
+
+private:
+	std::unique_ptr<Runtime> m_owned;
+	Runtime& m_runtime;
+};
+
+class HostPowEngine : public PowEngine
+{
+public:
+	HostPowEngine(HostSimd isa, unsigned threads)
+		: m_isa(isa)
+		, m_threads(threads)
+	{
+	}
+
+	std::string name() const override
+	{
+		return std::string("Host ") + toString(m_isa);
+	}
+
+	void pow(const double* a, const double* b, double* c, size_t n) override
+	{
+		powHost(a, b, c, n, m_isa, m_threads);
+	}
+
+private:
+	HostSimd m_isa;
+	unsigned m_threads;
+};
+
+} // namespace
+
+std::unique_ptr<PowEngine> createCL_PowEngine(const cl::Device& device)
+{
+	return std::unique_ptr<PowEngine>(new CL_PowEngine(device));
+}
+
+std::unique_ptr<PowEngine> createHostPowEngine(HostSimd isa, unsigned threads)
+{
+	return std::unique_ptr<PowEngine>(new HostPowEngine(isa, threads));
+}
+
+std::unique_ptr<PowEngine> createPowEngine()
+{
+	Runtime* runtime = Runtime::tryInstance();
+	if (runtime && hasCL_DoublePrecision(runtime->device()))
+		return std::unique_ptr<PowEngine>(new CL_PowEngine(*runtime));
+	return createHostPowEngine();
+}
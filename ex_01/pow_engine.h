@@ -0,0 +1,32 @@
+#ifndef POW_ENGINE_H
+#define POW_ENGINE_H
+
+#include "ocl_common.h"
+#include "host_pow.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// c[i] = pow(a[i], b[i]) in double precision, on whichever engine is available;
+// callers don't need to know which one runs.
+class PowEngine
+{
+public:
+	virtual ~PowEngine() {}
+
+	virtual std::string name() const = 0;
+	virtual void pow(const double* a, const double* b, double* c, size_t n) = 0;
+};
+
+// kernel1 on an OpenCL device, streamed so n isn't bounded by CL_DEVICE_MAX_MEM_ALLOC_SIZE
+std::unique_ptr<PowEngine> createCL_PowEngine(const cl::Device& device);
+
+// Vectorized host implementation, see powHost()
+std::unique_ptr<PowEngine> createHostPowEngine(HostSimd isa = detectHostSimd(), unsigned threads = 0);
+
+// OpenCL on the device of Runtime::instance(), or the host engine when there is no suitable
+// OpenCL platform or device, or that device has no double precision
+std::unique_ptr<PowEngine> createPowEngine();
+
+#endif // POW_ENGINE_H
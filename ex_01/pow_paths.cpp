@@ -0,0 +1,98 @@
+#include "pow_paths.h"
+#include "kernels.h"
+#include "runtime.h"
+
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+const char* toString(PowPath path)
+{
+	switch (path)
+	{
+	case PowPath::General:
+		return "pow";
+	case PowPath::ConstantExponent:
+		return "constant integer exponent";
+	case PowPath::IntegerExponents:
+		return "pown";
+	}
+	return "";
+}
+
+const char* toString(MathMode mode)
+{
+	switch (mode)
+	{
+	case MathMode::Strict:
+		return "strict";
+	case MathMode::Relaxed:
+		return "relaxed";
+	case MathMode::Native:
+		return "native";
+	case MathMode::Half:
+		return "half";
+	}
+	return "";
+}
+
+std::string mathCL_Options(MathMode mode)
+{
+	switch (mode)
+	{
+	case MathMode::Strict:
+		break;
+	case MathMode::Relaxed:
+		return " -DPOW_FN=powr -cl-fast-relaxed-math -cl-mad-enable -cl-denorms-are-zero";
+	case MathMode::Native:
+		return " -DPOW_FLOAT=native_powr";
+	case MathMode::Half:
+		return " -DPOW_FLOAT=half_powr";
+	}
+	return std::string();
+}
+
+bool isIntExponent(double y)
+{
+	return y == std::floor(y) && std::fabs(y) <= INT_MAX;
+}
+
+PowPath selectCL_PowPath(Runtime& rt, const Operand& b, size_t n)
+{
+	if (b.isScalar())
+		return isIntExponent(b.value()) ? PowPath::ConstantExponent : PowPath::General;
+	if (!n)
+		return PowPath::General;
+
+	// One pass over the exponents; the flag is only ever set to 1, so the write race is benign
+	const cl::Context& context = rt.context();
+	cl_int flag = 0;
+	cl::Buffer notIntegral(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(flag), &flag);
+	cl::Kernel scan(rt.program(kernelIntegralScan), "integral_scan");
+	const cl::CommandQueue& queue = rt.queue(); // ordered after the upload of the exponents
+	scan.setArg(0, static_cast<cl_ulong>(n));
+	scan.setArg(1, b.buffer());
+	scan.setArg(2, notIntegral);
+	queue.enqueueNDRangeKernel(scan, cl::NullRange, n, cl::NullRange);
+	queue.enqueueReadBuffer(notIntegral, CL_TRUE, 0, sizeof(flag), &flag);
+
+	return flag ? PowPath::General : PowPath::IntegerExponents;
+}
+
+cl::Kernel powCL_Kernel(Runtime& rt, const LaunchConfig& cfg, const Operand& a, const Operand& b, PowPath path,
+	MathMode mode)
+{
+	if ((path == PowPath::ConstantExponent && !(b.isScalar() && isIntExponent(b.value())))
+		|| (path == PowPath::IntegerExponents && b.isScalar()))
+		throw std::invalid_argument(std::string("The exponent doesn't fit the ") + toString(path) + " path.");
+
+	std::string options = cfg.options(a, b);
+	if (path == PowPath::ConstantExponent)
+		options += " -DPOW_INT=" + std::to_string(static_cast<int>(b.value()));
+	else if (path == PowPath::IntegerExponents)
+		options += " -DB_INT";
+	else
+		options += mathCL_Options(mode);
+	return cl::Kernel(rt.program(kernelTunable, options), "entry_point");
+}
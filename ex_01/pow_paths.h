@@ -0,0 +1,49 @@
+#ifndef POW_PATHS_H
+#define POW_PATHS_H
+
+#include "ocl_common.h"
+#include "autotune.h"
+#include "operand.h"
+
+#include <cstddef>
+#include <string>
+
+class Runtime;
+
+// How kernelTunable evaluates pow(a, b)
+enum class PowPath {
+	General,          // pow()
+	ConstantExponent, // uniform integral exponent compiled in as POW_INT
+	IntegerExponents  // exponent array of integers, pown()
+};
+
+const char* toString(PowPath path);
+
+// Accuracy against speed of the general path
+enum class MathMode {
+	Strict,  // pow, correctly handled special cases and full double precision
+	Relaxed, // powr with -cl-fast-relaxed-math -cl-mad-enable -cl-denorms-are-zero
+	Native,  // native_powr in single precision, implementation defined accuracy
+	Half     // half_powr in single precision, about 13 bits
+};
+// Every mode but Strict computes powr, so it is only defined for bases >= 0.
+
+const char* toString(MathMode mode);
+
+// Build options selecting the builtin of the mode
+std::string mathCL_Options(MathMode mode);
+
+// y is an integer within the range of int
+bool isIntExponent(double y);
+
+// Fastest path valid for the exponent: a scalar is checked on the host, a buffer of n exponents
+// by a scan kernel on the device. A program per distinct constant exponent is built, so callers
+// with many different ones may prefer IntegerExponents with a buffer.
+PowPath selectCL_PowPath(Runtime& rt, const Operand& b, size_t n);
+
+// Kernel of pow(a, b) for the launch geometry, operand kinds and path; 'mode' applies to the
+// General path, the integer ones are exact enough and don't call pow at all
+cl::Kernel powCL_Kernel(Runtime& rt, const LaunchConfig& cfg, const Operand& a, const Operand& b, PowPath path,
+	MathMode mode = MathMode::Strict);
+
+#endif // POW_PATHS_H
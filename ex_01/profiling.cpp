@@ -0,0 +1,135 @@
+#include "profiling.h"
+#include "utils.h"
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+
+const char* kindName(Profiler::Kind kind)
+{
+	switch (kind)
+	{
+	case Profiler::Write:
+		return "write";
+	case Profiler::Kernel:
+		return "kernel";
+	case Profiler::Read:
+		return "read";
+	case Profiler::Other:
+		break;
+	}
+	return "other";
+}
+
+} // namespace
+
+void Profiler::record(const std::string& name, Kind kind, const cl::Event& event, size_t amount, int lane)
+{
+	Entry e;
+	e.name = name;
+	e.kind = kind;
+	e.event = event;
+	e.amount = amount;
+	e.lane = lane;
+	m_entries.push_back(e);
+}
+
+Profiler::Times Profiler::times(const Entry& e)
+{
+	e.event.wait();
+	Times t;
+	t.queued = e.event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+	t.submit = e.event.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>();
+	t.start = e.event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+	t.end = e.event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+	return t;
+}
+
+void Profiler::writeChromeTrace(const std::string& path) const
+{
+	std::vector<Times> all;
+	cl_ulong origin = std::numeric_limits<uint64_t>::max();
+	for (auto& e : m_entries)
+	{
+		all.push_back(times(e));
+		if (all.back().queued < origin)
+			origin = all.back().queued;
+	}
+
+	std::ofstream out(path);
+	if (!out)
+		throw std::runtime_error("Can't write the trace to " + path);
+
+	// Complete ("X") events in microseconds from the first queued command
+	out << "{\"traceEvents\":[";
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		const Entry& e = m_entries[i];
+		const Times& t = all[i];
+		out << (i ? ",\n" : "\n")
+			<< "{\"name\":\"" << jsonEscape(e.name) << "\",\"cat\":\"" << kindName(e.kind) << "\""
+			<< ",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.lane
+			<< ",\"ts\":" << (t.start - origin) * 1e-3
+			<< ",\"dur\":" << (t.end - t.start) * 1e-3
+			<< ",\"args\":{\"queued_us\":" << (t.queued - origin) * 1e-3
+			<< ",\"submit_us\":" << (t.submit - origin) * 1e-3
+			<< ",\"" << (e.kind == Kernel ? "elements" : "bytes") << "\":" << e.amount << "}}";
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+double Profiler::deviceMs(Kind kind) const
+{
+	double ms = 0.0;
+	for (auto& e : m_entries)
+	{
+		if (e.kind != kind)
+			continue;
+		Times t = times(e);
+		ms += (t.end - t.start) * 1e-6;
+	}
+	return ms;
+}
+
+void Profiler::printSummary(std::ostream& os) const
+{
+	struct Sum
+	{
+		size_t count;
+		double amount;
+		double ms;
+		double waitMs; // queued to start
+	};
+	Sum sums[Other + 1] = {};
+
+	for (auto& e : m_entries)
+	{
+		Times t = times(e);
+		Sum& s = sums[e.kind];
+		s.count += 1;
+		s.amount += static_cast<double>(e.amount);
+		s.ms += (t.end - t.start) * 1e-6;
+		s.waitMs += (t.start - t.queued) * 1e-6;
+	}
+
+	for (int k = Write; k <= Other; ++k)
+	{
+		const Sum& s = sums[k];
+		if (!s.count)
+			continue;
+		os << kindName(static_cast<Kind>(k)) << ": " << s.count << " commands, " << s.ms << " ms device time, "
+			<< s.waitMs / s.count << " ms average queued->start";
+		if (s.ms > 0.0)
+		{
+			if (k == Kernel)
+				os << ", " << s.amount / s.ms * 1e-6 << " G elements/s";
+			else if (k != Other)
+				os << ", " << s.amount / s.ms * 1e-6 << " GB/s";
+		}
+		os << "\n";
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Device time of a chain of commands on a profiling queue, from the start of the first to the
+// end of the last, in milliseconds
+inline double eventSpanMs(const cl::Event& first, const cl::Event& last)
+{
+	cl_ulong start = first.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+	cl_ulong end = last.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+	return end > start ? (end - start) * 1e-6 : 0.0;
+}
+
+// Timeline of commands enqueued on CL_QUEUE_PROFILING_ENABLE queues.
+// Events are recorded as they are enqueued and only read when reported, so recording never
+// stalls the pipeline.
+class Profiler
+{
+public:
+	enum Kind {
+		Write,   // host to device, amount in bytes
+		Kernel,  // amount in elements
+		Read,    // device to host, amount in bytes
+		Other
+	};
+
+	// 'lane' becomes the trace's thread row, e.g. one per queue
+	void record(const std::string& name, Kind kind, const cl::Event& event, size_t amount, int lane = 0);
+
+	void clear() { m_entries.clear(); }
+	bool empty() const { return m_entries.empty(); }
+
+	// Chrome trace event JSON (chrome://tracing, Perfetto), waits for the recorded commands
+	void writeChromeTrace(const std::string& path) const;
+
+	// Sum of the device time of the commands of one kind, in milliseconds
+	double deviceMs(Kind kind) const;
+
+	// Per kind count, device time, GB/s for transfers and elements/s for kernels
+	void printSummary(std::ostream& os) const;
+
+private:
+	struct Entry
+	{
+		std::string name;
+		Kind kind;
+		cl::Event event;
+		size_t amount;
+		int lane;
+	};
+
+	struct Times
+	{
+		cl_ulong queued, submit, start, end;
+	};
+
+	static Times times(const Entry& e);
+
+	std::vector<Entry> m_entries;
+};
+
+#endif // PROFILING_H
@@ -0,0 +1,161 @@
+#include "program_cache.h"
+#include "utils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#  include <direct.h>
+#else
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#endif
+
+namespace {
+
+const char CACHE_MAGIC[] = "OCLPC1";
+
+void makeDir(const std::string& path)
+{
+#ifdef _WIN32
+	_mkdir(path.c_str());
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+// Everything that makes a binary unusable when it changes
+std::string cacheKey(const cl::Device& device, const std::string& source, const std::string& options)
+{
+	return device.getInfo<CL_DEVICE_NAME>() + "|" + device.getInfo<CL_DRIVER_VERSION>() + "|"
+		+ options + "|" + toHex(fnv1a64(source));
+}
+
+std::string cachePath(const std::string& dir, const std::string& key)
+{
+	return dir + "/" + toHex(fnv1a64(key)) + ".bin";
+}
+
+bool loadBinary(const std::string& path, const std::string& key, std::vector<unsigned char>& binary)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return false;
+
+	std::string magic, storedKey;
+	size_t size = 0;
+	if (!std::getline(in, magic) || magic != CACHE_MAGIC)
+		return false;
+	if (!std::getline(in, storedKey) || storedKey != key)
+		return false;
+	if (!(in >> size) || in.get() != '\n' || !size)
+		return false;
+
+	binary.resize(size);
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(binary.data()), size));
+}
+
+void storeBinary(const std::string& path, const std::string& key, const std::vector<unsigned char>& binary)
+{
+	// Write aside and rename, so a concurrent reader never sees a partial file
+	const std::string tmp = tempPathFor(path);
+	{
+		std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return;
+		out << CACHE_MAGIC << "\n" << key << "\n" << binary.size() << "\n";
+		out.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+		if (!out)
+		{
+			out.close();
+			std::remove(tmp.c_str());
+			return;
+		}
+	}
+	replaceFile(tmp, path);
+}
+
+cl::Program buildFromSource(const cl::Context& context, const cl::Device& device,
+	const std::string& source, const std::string& options)
+{
+	cl::Program program(context,
+		cl::Program::Sources(1, std::make_pair(source.c_str(), source.size())));
+
+	try {
+		program.build(std::vector<cl::Device>{ device }, options.c_str());
+	}
+	catch (const cl::Error& e) {
+		std::cerr << "CL program compilation error\n" << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device)
+			<< "\n/////////////////////////////////////\n" << source
+			<< "\n/////////////////////////////////////\n";
+		throw e;
+	}
+	return program;
+}
+
+} // namespace
+
+std::string getCL_CacheDir()
+{
+	if (std::getenv("OCL_NO_CACHE"))
+		return std::string();
+
+	const char* env = std::getenv("OCL_CACHE_DIR");
+	std::string dir = (env && *env) ? env : "ocl_cache";
+	makeDir(dir);
+	return dir;
+}
+
+void dropCL_CachedProgram(const cl::Device& device, const std::string& source, const std::string& options)
+{
+	std::string dir = getCL_CacheDir();
+	if (!dir.empty())
+		std::remove(cachePath(dir, cacheKey(device, source, options)).c_str());
+}
+
+cl::Program buildCL_Program(const cl::Context& context, const cl::Device& device,
+	const std::string& source, const std::string& options, bool* cached)
+{
+	if (cached)
+		*cached = false;
+
+	std::string dir = getCL_CacheDir();
+	if (dir.empty())
+		return buildFromSource(context, device, source, options);
+
+	std::string key = cacheKey(device, source, options);
+	std::string path = cachePath(dir, key);
+
+	std::vector<unsigned char> binary;
+	if (loadBinary(path, key, binary))
+	{
+		try {
+			cl::Program program(context, std::vector<cl::Device>{ device },
+				cl::Program::Binaries(1, std::make_pair(binary.data(), binary.size())));
+			program.build(std::vector<cl::Device>{ device }, options.c_str());
+			if (cached)
+				*cached = true;
+			return program;
+		}
+		catch (const cl::Error&) {
+			// The driver rejected the binary, forget it and compile from source
+			std::remove(path.c_str());
+		}
+	}
+
+	cl::Program program = buildFromSource(context, device, source, options);
+
+	// The program spans every device of the context, only the built one has a binary
+	auto devices = program.getInfo<CL_PROGRAM_DEVICES>();
+	auto binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+	for (size_t d = 0; d < devices.size() && d < binaries.size(); ++d)
+	{
+		if (devices[d]() == device() && !binaries[d].empty())
+			storeBinary(path, key, binaries[d]);
+	}
+
+	return program;
+}
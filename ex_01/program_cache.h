@@ -0,0 +1,23 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include "ocl_common.h"
+
+#include <string>
+
+// Build 'source' for 'device'. A program binary saved by an earlier run is reused when its
+// key (source hash, build options, device name, driver version) matches; a missing, stale or
+// rejected binary falls back to a source build whose result is written back to the cache.
+// 'cached' reports whether the binary path was taken.
+cl::Program buildCL_Program(const cl::Context& context, const cl::Device& device,
+	const std::string& source, const std::string& options = std::string(), bool* cached = nullptr);
+
+// Cache directory: $OCL_CACHE_DIR if set, "ocl_cache" in the working directory otherwise.
+// Setting OCL_NO_CACHE disables the cache altogether.
+std::string getCL_CacheDir();
+
+// Remove the cache entry of a source/options pair for the device, if there is one
+void dropCL_CachedProgram(const cl::Device& device, const std::string& source,
+	const std::string& options = std::string());
+
+#endif // PROGRAM_CACHE_H
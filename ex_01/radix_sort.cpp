@@ -0,0 +1,112 @@
+#include "radix_sort.h"
+#include "kernels.h"
+#include "runtime.h"
+#include "scan.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// RADIX and ITEMS of kernelRadixSort
+const size_t RADIX = 16;
+const size_t ITEMS = 4;
+
+std::string sortOptions(const std::string& keyType, size_t keySize, size_t valueSize)
+{
+	std::string options = keySize == 8 ? "-DKEY=ulong -DKEY_BITS=64" : "-DKEY=uint -DKEY_BITS=32";
+	if (keyType == "float" || keyType == "double")
+		options += " -DKEY_FLOAT";
+	else if (keyType == "int" || keyType == "long")
+		options += " -DKEY_SIGNED";
+	else if (keyType != "uint" && keyType != "ulong")
+		throw std::invalid_argument("No radix sort for keys of type " + keyType);
+	if (valueSize)
+		options += valueSize == 8 ? " -DVALUE=ulong" : " -DVALUE=uint";
+	return options;
+}
+
+// Work-group size: counts take RADIX uints per work-item, the scan totals one more
+size_t sortLocal(const cl::Device& device, const cl::Kernel& count, const cl::Kernel& scatter)
+{
+	const size_t limit = std::min({ size_t(256), static_cast<size_t>(device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>()),
+		count.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device),
+		scatter.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device) });
+	const size_t localMem = static_cast<size_t>(device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>())
+		- static_cast<size_t>(scatter.getWorkGroupInfo<CL_KERNEL_LOCAL_MEM_SIZE>(device));
+	const size_t local = std::min(limit, localMem / ((RADIX + 1) * sizeof(cl_uint)));
+	if (local < RADIX)
+		throw std::runtime_error("The radix sort needs work-groups of at least 16 items");
+	return local;
+}
+
+void enqueueElementwise(Runtime& rt, cl::Kernel& kernel, const cl::Buffer& keys, size_t n)
+{
+	kernel.setArg(0, static_cast<cl_ulong>(n));
+	kernel.setArg(1, keys);
+	rt.queue().enqueueNDRangeKernel(kernel, cl::NullRange, n, cl::NullRange);
+}
+
+} // namespace
+
+void sortCL_Buffer(Runtime& rt, const char* keyType, size_t keySize, const cl::Buffer& keys, size_t n,
+	const cl::Buffer& values, size_t valueSize)
+{
+	if (keySize != 4 && keySize != 8)
+		throw std::invalid_argument("Radix sort keys have 4 or 8 bytes");
+	if (values() && valueSize != 4 && valueSize != 8)
+		throw std::invalid_argument("Radix sort values have 4 or 8 bytes");
+	if (n > UINT32_MAX)
+		throw std::invalid_argument("The radix sort takes less than 2^32 keys");
+	if (n < 2)
+		return;
+
+	const cl::Device& device = rt.device();
+	const cl::Context& context = rt.context();
+	const cl::CommandQueue& queue = rt.queue();
+	const size_t payload = values() ? valueSize : 0;
+	cl::Program program = rt.program(kernelRadixSort, sortOptions(keyType, keySize, payload));
+	cl::Kernel encode(program, "radix_encode"), decode(program, "radix_decode");
+	cl::Kernel count(program, "radix_count"), scatter(program, "radix_scatter");
+
+	const size_t local = sortLocal(device, count, scatter);
+	const size_t groups = (n + local * ITEMS - 1) / (local * ITEMS);
+	cl::Buffer histogram(context, CL_MEM_READ_WRITE, RADIX * groups * sizeof(cl_uint));
+
+	// Ping-pong between the caller's buffers and these; the pass count is even, so the result
+	// ends where it started
+	cl::Buffer keysIn = keys, keysOut(context, CL_MEM_READ_WRITE, n * keySize);
+	cl::Buffer valuesIn = values, valuesOut = payload ? cl::Buffer(context, CL_MEM_READ_WRITE, n * payload) : cl::Buffer();
+
+	enqueueElementwise(rt, encode, keys, n);
+	for (cl_uint shift = 0; shift < keySize * 8; shift += 4)
+	{
+		count.setArg(0, static_cast<cl_ulong>(n));
+		count.setArg(1, keysIn);
+		count.setArg(2, shift);
+		count.setArg(3, histogram);
+		count.setArg(4, cl::Local(RADIX * local * sizeof(cl_uint)));
+		queue.enqueueNDRangeKernel(count, cl::NullRange, groups * local, local);
+
+		scanCL_Buffer(rt, "uint", sizeof(cl_uint), histogram, histogram, RADIX * groups, false);
+
+		cl_uint arg = 0;
+		scatter.setArg(arg++, static_cast<cl_ulong>(n));
+		scatter.setArg(arg++, keysIn);
+		scatter.setArg(arg++, keysOut);
+		if (payload)
+		{
+			scatter.setArg(arg++, valuesIn);
+			scatter.setArg(arg++, valuesOut);
+		}
+		scatter.setArg(arg++, shift);
+		scatter.setArg(arg++, histogram);
+		scatter.setArg(arg++, cl::Local(RADIX * local * sizeof(cl_uint)));
+		scatter.setArg(arg++, cl::Local(local * sizeof(cl_uint)));
+		queue.enqueueNDRangeKernel(scatter, cl::NullRange, groups * local, local);
+
+		std::swap(keysIn, keysOut);
+		std::swap(valuesIn, valuesOut);
+	}
+	enqueueElementwise(rt, decode, keys, n);
+}
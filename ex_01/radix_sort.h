@@ -0,0 +1,44 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include "device_vector.h"
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+class Runtime;
+
+// Sort the n keys in 'keys' on the device, ascending and stable, with kernelRadixSort: 4 bits
+// per pass, so 8 passes for 32-bit keys and 16 for 64-bit ones. 'keyType' is the OpenCL C type:
+// uint, ulong, int, long, float or double (-0 before +0; NaNs of either sign come out as the
+// positive quiet NaN, after +infinity, their payloads lost). 'values', when not null, holds n
+// payloads of 'valueSize' bytes (4 or 8) which move with their keys. The work-group size is
+// the largest the kernels, CL_DEVICE_MAX_WORK_GROUP_SIZE and CL_DEVICE_LOCAL_MEM_SIZE allow, up
+// to 256. Enqueued on the runtime's queue, n < 2^32.
+void sortCL_Buffer(Runtime& rt, const char* keyType, size_t keySize, const cl::Buffer& keys, size_t n,
+	const cl::Buffer& values = cl::Buffer(), size_t valueSize = 0);
+
+namespace ocl {
+
+template<class K>
+void sort(DeviceVector<K>& keys)
+{
+	sortCL_Buffer(keys.runtime(), ClType<K>::name(), sizeof(K), keys.bufferForWriting(), keys.size());
+}
+
+// Sort 'keys' and permute 'values' (4 or 8 byte elements) the same way
+template<class K, class V>
+void sortByKey(DeviceVector<K>& keys, DeviceVector<V>& values)
+{
+	if (keys.size() != values.size())
+		throw std::invalid_argument("Sorting " + std::to_string(keys.size()) + " keys with "
+			+ std::to_string(values.size()) + " values");
+	sortCL_Buffer(keys.runtime(), ClType<K>::name(), sizeof(K), keys.bufferForWriting(), keys.size(),
+		values.bufferForWriting(), sizeof(V));
+}
+
+} // namespace ocl
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,108 @@
+#include "random.h"
+#include "kernels.h"
+#include "runtime.h"
+
+#include <cmath>
+
+namespace {
+
+const double TWO_PI = 6.283185307179586476925;
+
+// The top 53 bits of (hi, lo) as a double in [0, 1), as unit() in kernelRandom
+double unit(uint32_t lo, uint32_t hi)
+{
+	return static_cast<double>(((static_cast<uint64_t>(hi) << 32) | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Elements 2p and 2p + 1 of the sequence
+void pair(const RandomSpec& spec, const uint32_t key[2], uint64_t p, double v[2])
+{
+	const uint32_t counter[4] = { static_cast<uint32_t>(p), static_cast<uint32_t>(p >> 32), 0, 0 };
+	uint32_t x[4];
+	philox4x32_10(counter, key, x);
+	const double u0 = unit(x[0], x[1]), u1 = unit(x[2], x[3]);
+	const double a = spec.a, b = spec.b;
+	if (spec.distribution == Distribution::Normal)
+	{
+		const double r = std::sqrt(-2.0 * std::log(1.0 - u0));
+		v[0] = a + b * (r * std::cos(TWO_PI * u1));
+		v[1] = a + b * (r * std::sin(TWO_PI * u1));
+	}
+	else
+	{
+		v[0] = a + (b - a) * u0;
+		v[1] = a + (b - a) * u1;
+	}
+}
+
+} // namespace
+
+const char* toString(Distribution d)
+{
+	switch (d)
+	{
+	case Distribution::Uniform:
+		return "uniform";
+	case Distribution::Normal:
+		return "normal";
+	}
+	return "";
+}
+
+void philox4x32_10(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int round = 0; round < 10; ++round)
+	{
+		if (round)
+		{
+			k0 += 0x9e3779b9u;
+			k1 += 0xbb67ae85u;
+		}
+		const uint64_t p0 = static_cast<uint64_t>(0xd2511f53u) * c0;
+		const uint64_t p1 = static_cast<uint64_t>(0xcd9e8d57u) * c2;
+		const uint32_t next0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+		const uint32_t next2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+		c1 = static_cast<uint32_t>(p1);
+		c3 = static_cast<uint32_t>(p0);
+		c0 = next0;
+		c2 = next2;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+void randomHost(const RandomSpec& spec, uint64_t seed, size_t first, size_t count, double* out)
+{
+	const uint32_t key[2] = { static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+	double v[2];
+	for (size_t i = first; i < first + count; ++i)
+	{
+		if (i == first || !(i & 1))
+			pair(spec, key, i / 2, v);
+		out[i - first] = v[i & 1];
+	}
+}
+
+cl::Event randomCL_Buffer(Runtime& rt, const RandomSpec& spec, uint64_t seed, const cl::Buffer& out, size_t n,
+	size_t first)
+{
+	cl::Event done;
+	if (!n)
+		return done;
+
+	cl::Kernel kernel(rt.program(kernelRandom, spec.distribution == Distribution::Normal ? "-DNORMAL" : ""),
+		"philox_fill");
+	kernel.setArg(0, static_cast<cl_ulong>(first));
+	kernel.setArg(1, static_cast<cl_ulong>(n));
+	kernel.setArg(2, out);
+	kernel.setArg(3, static_cast<cl_ulong>(seed));
+	kernel.setArg(4, spec.a);
+	kernel.setArg(5, spec.b);
+	const size_t pairs = (first + n + 1) / 2 - first / 2;
+	rt.queue().enqueueNDRangeKernel(kernel, cl::NullRange, pairs, cl::NullRange, nullptr, &done);
+	return done;
+}
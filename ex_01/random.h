@@ -0,0 +1,51 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include "device_vector.h"
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class Runtime;
+
+enum class Distribution {
+	Uniform,  // in [a, b)
+	Normal    // mean a, standard deviation b, by Box-Muller
+};
+
+const char* toString(Distribution d);
+
+struct RandomSpec
+{
+	Distribution distribution{ Distribution::Uniform };
+	double a{ 0.0 };
+	double b{ 1.0 };
+};
+
+// Philox4x32-10 block of 'counter' under 'key'
+void philox4x32_10(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+// Elements [first, first + count) of the sequence of 'seed' (see kernelRandom): element i comes
+// from block i / 2 only, so any range can be generated on its own, on the host or the device.
+// Uniform values are identical on both; normal ones differ by the device's log, sin and cos,
+// a few ULP at most.
+void randomHost(const RandomSpec& spec, uint64_t seed, size_t first, size_t count, double* out);
+
+// Enqueue the generation of elements [first, first + n) of the sequence of 'seed' into 'out'
+cl::Event randomCL_Buffer(Runtime& rt, const RandomSpec& spec, uint64_t seed, const cl::Buffer& out, size_t n,
+	size_t first = 0);
+
+namespace ocl {
+
+// Fill v with the start of the sequence of 'seed', in place on its device
+inline cl::Event fillRandom(DeviceVector<double>& v, const RandomSpec& spec, uint64_t seed)
+{
+	if (!v.size())
+		return cl::Event();
+	return randomCL_Buffer(v.runtime(), spec, seed, v.bufferForWriting(), v.size());
+}
+
+} // namespace ocl
+
+#endif // RANDOM_H
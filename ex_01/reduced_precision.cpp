@@ -0,0 +1,96 @@
+#include "reduced_precision.h"
+#include "device_info.h"
+#include "host_convert.h"
+#include "kernels.h"
+#include "runtime.h"
+#include "staged_pow.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Floats per element on the device
+size_t width(Precision precision)
+{
+	return precision == Precision::DoubleFloat ? 2 : 1;
+}
+
+// Rounded to float, or split into the float pair hi + lo
+void toDevice(Precision precision, const double* src, float* dst, size_t n)
+{
+	if (precision == Precision::DoubleFloat)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			const float hi = static_cast<float>(src[i]);
+			dst[2 * i] = hi;
+			dst[2 * i + 1] = static_cast<float>(src[i] - hi);
+		}
+	}
+	else
+		convertToFloat(src, dst, n);
+}
+
+void fromDevice(Precision precision, const float* src, double* dst, size_t n)
+{
+	if (precision == Precision::DoubleFloat)
+	{
+		for (size_t i = 0; i < n; ++i)
+			dst[i] = static_cast<double>(src[2 * i]) + src[2 * i + 1];
+	}
+	else
+		convertFromFloat(src, dst, n);
+}
+
+} // namespace
+
+const char* toString(Precision precision)
+{
+	switch (precision)
+	{
+	case Precision::Double:
+		return "double";
+	case Precision::Float:
+		return "float";
+	case Precision::DoubleFloat:
+		return "double-float";
+	}
+	return "";
+}
+
+Precision defaultCL_Precision(const cl::Device& device)
+{
+	return hasCL_DoublePrecision(device) ? Precision::Double : Precision::DoubleFloat;
+}
+
+void powCL_Reduced(Runtime& rt, Precision precision, const double* a, const double* b, double exponent,
+	double* c, size_t n, Profiler* profiler)
+{
+	if (precision == Precision::Double)
+		throw std::invalid_argument("powCL_Reduced() computes in float or double-float precision only.");
+	if (!n)
+		return;
+
+	std::string options = precision == Precision::DoubleFloat ? "-DDOUBLE_FLOAT" : "";
+	if (!b)
+		options += " -DB_SCALAR";
+	cl::Kernel kernel(rt.program(kernelReduced, options), "entry_point");
+	if (!b && precision == Precision::DoubleFloat)
+	{
+		cl_float2 e;
+		toDevice(precision, &exponent, e.s, 1);
+		kernel.setArg(2, e);
+	}
+	else if (!b)
+		kernel.setArg(2, static_cast<cl_float>(exponent));
+
+	powCL_Staged(rt, kernel, width(precision) * sizeof(float),
+		[precision](const double* src, void* dst, size_t count) {
+			toDevice(precision, src, static_cast<float*>(dst), count);
+		},
+		[precision](const void* src, double* dst, size_t count) {
+			fromDevice(precision, static_cast<const float*>(src), dst, count);
+		},
+		a, b, c, n, profiler, toString(precision));
+}
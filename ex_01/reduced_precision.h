@@ -0,0 +1,30 @@
+#ifndef REDUCED_PRECISION_H
+#define REDUCED_PRECISION_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+
+class Profiler;
+class Runtime;
+
+// Arithmetic of the device side pow
+enum class Precision {
+	Double,      // native fp64, kernel1 and kernelTunable
+	Float,       // single precision, half the bytes to move
+	DoubleFloat  // (hi, lo) float pairs, about 44 bits while results stay within 1e-30..1e30
+};
+
+const char* toString(Precision precision);
+
+// Double when the device reports cl_khr_fp64 or cl_amd_fp64, DoubleFloat otherwise
+Precision defaultCL_Precision(const cl::Device& device);
+
+// c[i] = pow(a[i], b[i]) with kernelReduced in Float or DoubleFloat precision, the host converting
+// to and from floats (or float pairs). With a null 'b' every element is raised to 'exponent',
+// which goes as a kernel argument. Runs on any device, double precision or not. With a
+// 'profiler' the transfers and the kernel are recorded, on a profiling queue.
+void powCL_Reduced(Runtime& rt, Precision precision, const double* a, const double* b, double exponent,
+	double* c, size_t n, Profiler* profiler = nullptr);
+
+#endif // REDUCED_PRECISION_H
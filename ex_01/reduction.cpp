@@ -0,0 +1,222 @@
+#include "reduction.h"
+#include "device_info.h"
+#include "kernels.h"
+#include "runtime.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace {
+
+const char* opOption(ReduceOp op)
+{
+	switch (op)
+	{
+	case ReduceOp::Sum:
+		return " -DOP_SUM";
+	case ReduceOp::Min:
+		return " -DOP_MIN";
+	case ReduceOp::Max:
+		return " -DOP_MAX";
+	case ReduceOp::ArgMin:
+		return " -DOP_ARGMIN";
+	}
+	return "";
+}
+
+// Largest power of two not above n, at least 1
+size_t floorPow2(size_t n)
+{
+	size_t p = 1;
+	while (p * 2 <= n)
+		p *= 2;
+	return p;
+}
+
+// One pass of kernelReduce: 'groups' work-groups of 'local' items per segment
+void enqueuePass(Runtime& rt, cl::Kernel& kernel, size_t local, size_t groups, size_t n, size_t segment,
+	size_t segments, size_t size, const void* identity, const cl::Buffer& in, const cl::Buffer& inIndex,
+	const cl::Buffer& out, const cl::Buffer& outIndex)
+{
+	kernel.setArg(0, static_cast<cl_ulong>(n));
+	kernel.setArg(1, static_cast<cl_ulong>(segment));
+	kernel.setArg(2, static_cast<cl_uint>(groups));
+	kernel.setArg(3, size, identity);
+	kernel.setArg(4, in);
+	kernel.setArg(5, inIndex);
+	kernel.setArg(6, out);
+	kernel.setArg(7, outIndex);
+	kernel.setArg(8, cl::Local(local * size));
+	kernel.setArg(9, cl::Local((outIndex() ? local : 1) * sizeof(cl_ulong)));
+	rt.queue().enqueueNDRangeKernel(kernel, cl::NullRange, segments * groups * local, local);
+}
+
+} // namespace
+
+const char* toString(ReduceOp op)
+{
+	switch (op)
+	{
+	case ReduceOp::Sum:
+		return "sum";
+	case ReduceOp::Min:
+		return "min";
+	case ReduceOp::Max:
+		return "max";
+	case ReduceOp::ArgMin:
+		return "argmin";
+	}
+	return "";
+}
+
+std::string toString(const ReduceConfig& cfg)
+{
+	std::ostringstream s;
+	s << "local " << cfg.local << ", " << (cfg.groups ? std::to_string(cfg.groups) : std::string("auto"))
+		<< " groups per segment" << (cfg.subGroups ? ", sub-groups" : "");
+	return s.str();
+}
+
+void reduceCL_Buffer(Runtime& rt, const ReduceConfig& cfg, ReduceOp op, const char* type, size_t size,
+	const void* identity, const cl::Buffer& in, size_t n, size_t segments, void* values, uint64_t* indices)
+{
+	if (!segments)
+		throw std::invalid_argument("A reduction needs at least one segment");
+	const bool arg = op == ReduceOp::ArgMin;
+	const size_t segment = (n + segments - 1) / segments;
+	if (!segment)
+	{
+		for (size_t s = 0; s < segments; ++s)
+		{
+			std::memcpy(static_cast<char*>(values) + s * size, identity, size);
+			if (arg)
+				indices[s] = UINT64_MAX;
+		}
+		return;
+	}
+
+	const cl::Device& device = rt.device();
+	std::string options = std::string("-DT=") + type + opOption(op);
+	if (cfg.subGroups)
+		options += subGroupCL_Options(device) + " -DUSE_SUBGROUPS";
+	cl::Kernel first(rt.program(kernelReduce, options), "reduce");
+
+	const size_t local = floorPow2(std::min(cfg.local, first.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device)));
+	const size_t wanted = cfg.groups ? cfg.groups : 4 * device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+	const size_t groups = std::max<size_t>(1, std::min(wanted, (segment + local - 1) / local));
+
+	const cl::Context& context = rt.context();
+	cl::Buffer result(context, CL_MEM_READ_WRITE, segments * size);
+	cl::Buffer resultIndex = arg ? cl::Buffer(context, CL_MEM_READ_WRITE, segments * sizeof(cl_ulong)) : cl::Buffer();
+	if (groups == 1)
+		enqueuePass(rt, first, local, 1, n, segment, segments, size, identity, in, cl::Buffer(), result, resultIndex);
+	else
+	{
+		// Partial results of every work-group, reduced by one work-group per segment
+		cl::Buffer partial(context, CL_MEM_READ_WRITE, segments * groups * size);
+		cl::Buffer partialIndex = arg
+			? cl::Buffer(context, CL_MEM_READ_WRITE, segments * groups * sizeof(cl_ulong)) : cl::Buffer();
+		enqueuePass(rt, first, local, groups, n, segment, segments, size, identity, in, cl::Buffer(), partial,
+			partialIndex);
+
+		cl::Kernel second = arg ? cl::Kernel(rt.program(kernelReduce, options + " -DINDEX_IN"), "reduce")
+			: cl::Kernel(rt.program(kernelReduce, options), "reduce");
+		enqueuePass(rt, second, std::min(local, floorPow2(groups)), 1, segments * groups, groups, segments, size,
+			identity, partial, partialIndex, result, resultIndex);
+	}
+
+	const cl::CommandQueue& queue = rt.queue();
+	queue.enqueueReadBuffer(result, CL_TRUE, 0, segments * size, values);
+	if (arg)
+		queue.enqueueReadBuffer(resultIndex, CL_TRUE, 0, segments * sizeof(cl_ulong), indices);
+}
+
+ReduceConfig tuneCL_ReduceConfig(Runtime& rt, size_t sampleElems)
+{
+	const cl::Device& device = rt.device();
+	const bool fp64 = hasCL_DoublePrecision(device);
+	const size_t size = fp64 ? sizeof(cl_double) : sizeof(cl_float);
+	const size_t n = std::max<size_t>(1, clampToAlloc(device, sampleElems, size));
+
+	std::vector<double> sample = randomVector(n, -1.0, 1.0);
+	std::vector<float> sampleFloat(fp64 ? 0 : n);
+	std::copy(sample.begin(), sample.end(), sampleFloat.begin());
+	cl::Buffer in(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, n * size,
+		fp64 ? static_cast<void*>(sample.data()) : static_cast<void*>(sampleFloat.data()));
+
+	const double zero = 0.0;
+	const float zeroFloat = 0.0f;
+	ReduceConfig best;
+	best.ms = -1.0;
+	auto consider = [&](const ReduceConfig& cfg) {
+		try {
+			double result[1];
+			auto run = [&] {
+				reduceCL_Buffer(rt, cfg, ReduceOp::Sum, fp64 ? "double" : "float", size,
+					fp64 ? static_cast<const void*>(&zero) : static_cast<const void*>(&zeroFloat), in, n, 1, result,
+					nullptr);
+			};
+			run();
+			std::vector<double> ms;
+			for (int r = 0; r < 3; ++r)
+			{
+				Stopwatch sw;
+				run();
+				ms.push_back(sw.elapsedMs());
+			}
+			const double median = percentile(ms, 50.0);
+			if (best.ms < 0.0 || median < best.ms)
+			{
+				best = cfg;
+				best.ms = median;
+			}
+		}
+		catch (const cl::Error&) {
+			// The device refuses this geometry or variant
+		}
+	};
+
+	std::vector<bool> variants{ false };
+	if (hasCL_SubGroups(device))
+		variants.push_back(true);
+	const size_t maxLocal = std::min<size_t>(1024, device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
+	for (bool subGroups : variants)
+	{
+		for (size_t local = 64; local <= maxLocal; local *= 2)
+		{
+			ReduceConfig cfg;
+			cfg.local = local;
+			cfg.subGroups = subGroups;
+			consider(cfg);
+		}
+	}
+	if (best.ms < 0.0)
+		throw std::runtime_error("No configuration of the reduction kernel runs on " + device.getInfo<CL_DEVICE_NAME>());
+
+	// Work-groups per segment for that size, multiples of the compute units
+	const size_t units = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+	const ReduceConfig shape = best;
+	for (size_t perUnit : { 1, 2, 8, 16 })
+	{
+		ReduceConfig cfg = shape;
+		cfg.groups = perUnit * units;
+		consider(cfg);
+	}
+	return best;
+}
+
+ReduceConfig getCL_ReduceConfig(Runtime& rt)
+{
+	static std::mutex mutex;
+	static std::map<cl_device_id, ReduceConfig> tuned;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = tuned.find(rt.device()());
+	if (it == tuned.end())
+		it = tuned.insert(std::make_pair(rt.device()(), tuneCL_ReduceConfig(rt))).first;
+	return it->second;
+}
@@ -0,0 +1,115 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include "device_vector.h"
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class Runtime;
+
+enum class ReduceOp {
+	Sum,
+	Min,
+	Max,
+	ArgMin  // index of the smallest element, the first one among equals
+};
+
+const char* toString(ReduceOp op);
+
+// Geometry of kernelReduce
+struct ReduceConfig
+{
+	size_t local{ 256 };      // work-group size, a power of two
+	size_t groups{ 0 };       // work-groups per segment in the first pass, 0 for 4 per compute unit
+	bool subGroups{ false };  // sub-group built-ins before local memory, see hasCL_SubGroups()
+	double ms{ 0.0 };         // time measured when tuning
+};
+
+std::string toString(const ReduceConfig& cfg);
+
+// Time work-group sizes, then work-groups per segment for the best one, each with and without
+// sub-groups when the device has them, on a sum of 'sampleElems' doubles (floats without fp64)
+ReduceConfig tuneCL_ReduceConfig(Runtime& rt, size_t sampleElems = size_t(1) << 22);
+
+// tuneCL_ReduceConfig() once per device and process
+ReduceConfig getCL_ReduceConfig(Runtime& rt);
+
+// Reduce n elements of OpenCL C type 'type' ('size' bytes each) in 'in', split in 'segments'
+// consecutive parts of ceil(n / segments) elements, the last one shorter. A first pass leaves
+// one partial result per work-group, a second one (when there is more than one group per
+// segment) reduces those. 'values' receives one result per segment, 'identity' for empty ones;
+// 'indices' the element index of each ArgMin, UINT64_MAX when there was none. Blocking.
+void reduceCL_Buffer(Runtime& rt, const ReduceConfig& cfg, ReduceOp op, const char* type, size_t size,
+	const void* identity, const cl::Buffer& in, size_t n, size_t segments, void* values, uint64_t* indices);
+
+namespace ocl {
+
+// Result of reducing no element
+template<class T>
+T reduceIdentity(ReduceOp op)
+{
+	typedef std::numeric_limits<T> Limits;
+	switch (op)
+	{
+	case ReduceOp::Sum:
+		return T(0);
+	case ReduceOp::Max:
+		return Limits::has_infinity ? -Limits::infinity() : Limits::lowest();
+	default:
+		return Limits::has_infinity ? Limits::infinity() : Limits::max();
+	}
+}
+
+// Sum, Min or Max of each of 'segments' consecutive parts of v, on its device
+template<class T>
+std::vector<T> reduce(const DeviceVector<T>& v, ReduceOp op, size_t segments)
+{
+	if (op == ReduceOp::ArgMin)
+		throw std::invalid_argument("ocl::reduce() gives values, use ocl::argmin() for indices");
+	Runtime& rt = v.runtime();
+	const T identity = reduceIdentity<T>(op);
+	std::vector<T> values(segments);
+	reduceCL_Buffer(rt, getCL_ReduceConfig(rt), op, ClType<T>::name(), sizeof(T), &identity, v.buffer(), v.size(),
+		segments, values.data(), nullptr);
+	return values;
+}
+
+template<class T>
+T reduce(const DeviceVector<T>& v, ReduceOp op)
+{
+	return reduce(v, op, 1).front();
+}
+
+// Index of the smallest element of each of 'segments' consecutive parts of v, v.size() for a
+// part which has none (empty, or all NaN)
+template<class T>
+std::vector<size_t> argmin(const DeviceVector<T>& v, size_t segments)
+{
+	Runtime& rt = v.runtime();
+	const T identity = reduceIdentity<T>(ReduceOp::ArgMin);
+	std::vector<T> values(segments);
+	std::vector<uint64_t> indices(segments);
+	reduceCL_Buffer(rt, getCL_ReduceConfig(rt), ReduceOp::ArgMin, ClType<T>::name(), sizeof(T), &identity,
+		v.buffer(), v.size(), segments, values.data(), indices.data());
+
+	std::vector<size_t> found(segments);
+	for (size_t s = 0; s < segments; ++s)
+		found[s] = indices[s] == UINT64_MAX ? v.size() : static_cast<size_t>(indices[s]);
+	return found;
+}
+
+template<class T>
+size_t argmin(const DeviceVector<T>& v)
+{
+	return argmin(v, 1).front();
+}
+
+} // namespace ocl
+
+#endif // REDUCTION_H
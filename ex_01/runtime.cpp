@@ -0,0 +1,77 @@
+#include "runtime.h"
+#include "device_info.h"
+#include "program_cache.h"
+
+#include <iostream>
+#include <stdexcept>
+
+bool Runtime::s_profiling = false;
+
+Runtime& Runtime::instance()
+{
+	static Runtime runtime(getCL_Device(), s_profiling, true);
+	return runtime;
+}
+
+Runtime* Runtime::tryInstance()
+{
+	try {
+		return &instance();
+	}
+	catch (const cl::Error& err) {
+		std::cerr << "OpenCL is not available: " << err.what() << "(" << err.err() << ")\n";
+	}
+	catch (const std::domain_error& err) {
+		std::cerr << "OpenCL is not available: " << err.what() << "\n";
+	}
+	return nullptr;
+}
+
+void Runtime::setProfiling(bool enable)
+{
+	s_profiling = enable;
+}
+
+Runtime::Runtime(const cl::Device& device, bool profiling)
+	: Runtime(device, profiling, false)
+{
+}
+
+Runtime::Runtime(const cl::Device& device, bool profiling, bool makeDefault)
+	: m_device(device)
+	, m_context(device)
+	, m_queue(m_context, device, profiling ? CL_QUEUE_PROFILING_ENABLE : 0)
+	, m_profiling(profiling)
+	, m_bufferPool(m_context)
+{
+	if (makeDefault)
+	{
+		cl::Device::setDefault(m_device);
+		cl::Context::setDefault(m_context);
+		cl::CommandQueue::setDefault(m_queue);
+	}
+}
+
+cl::Program Runtime::program(const std::string& source, const std::string& options)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	ProgramKey key(source, options);
+	auto it = m_programs.find(key);
+	if (it == m_programs.end())
+		it = m_programs.insert(std::make_pair(key, buildCL_Program(m_context, m_device, source, options))).first;
+	return it->second;
+}
+
+cl::Kernel Runtime::kernel(const std::string& source, const std::string& name, const std::string& options)
+{
+	cl::Program prog = program(source, options);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto key = std::make_pair(ProgramKey(source, options), name);
+	auto it = m_kernels.find(key);
+	if (it == m_kernels.end())
+		it = m_kernels.insert(std::make_pair(key, cl::Kernel(prog, name.c_str()))).first;
+	return it->second;
+}
@@ -0,0 +1,68 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include "buffer_pool.h"
+#include "ocl_common.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// Long lived device, context and command queue, with programs and kernels compiled once and
+// reused, so that submitting a job costs only its transfers and kernel launches.
+class Runtime
+{
+public:
+	// Process wide runtime on the device found by getCL_Device(), created on first use.
+	// Its device, context and queue also become cl2.hpp's defaults.
+	static Runtime& instance();
+
+	// instance(), or nullptr with the reason on std::cerr when there is no suitable OpenCL
+	// platform or device
+	static Runtime* tryInstance();
+
+	// Create the queue of instance() with CL_QUEUE_PROFILING_ENABLE, so its commands can be
+	// timed with a Profiler. Only effective before the first instance() call.
+	static void setProfiling(bool enable);
+
+	explicit Runtime(const cl::Device& device, bool profiling = false);
+
+	Runtime(const Runtime&) = delete;
+	Runtime& operator=(const Runtime&) = delete;
+
+	const cl::Device& device() const { return m_device; }
+	const cl::Context& context() const { return m_context; }
+	const cl::CommandQueue& queue() const { return m_queue; }
+	bool profiling() const { return m_profiling; }
+
+	// Buffers of the context for reuse between jobs
+	BufferPool& bufferPool() { return m_bufferPool; }
+
+	// Program of 'source' built with 'options', compiled (or taken from the program cache) once
+	cl::Program program(const std::string& source, const std::string& options = std::string());
+
+	// Kernel 'name' of that program, created once. The object is shared by every caller and
+	// kernel arguments are part of it, so concurrent submitters should use their own kernels.
+	cl::Kernel kernel(const std::string& source, const std::string& name,
+		const std::string& options = std::string());
+
+private:
+	Runtime(const cl::Device& device, bool profiling, bool makeDefault);
+
+	static bool s_profiling;
+
+	typedef std::pair<std::string, std::string> ProgramKey;
+
+	cl::Device m_device;
+	cl::Context m_context;
+	cl::CommandQueue m_queue;
+	bool m_profiling;
+	BufferPool m_bufferPool;
+
+	std::mutex m_mutex;
+	std::map<ProgramKey, cl::Program> m_programs;
+	std::map<std::pair<ProgramKey, std::string>, cl::Kernel> m_kernels;
+};
+
+#endif // RUNTIME_H
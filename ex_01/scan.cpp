@@ -0,0 +1,108 @@
+#include "scan.h"
+#include "kernels.h"
+#include "runtime.h"
+
+#include <algorithm>
+
+namespace {
+
+// Elements per work-item, ITEMS in kernelScan
+const size_t ITEMS = 4;
+
+// Work-group size of a scan kernel: the Hillis-Steele steps grow with its logarithm, and 256
+// items already make blocks of 1024 elements
+size_t scanLocal(const cl::Kernel& kernel, const cl::Device& device)
+{
+	return std::min<size_t>(256, kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+}
+
+// Scan n elements with 'blocks' (scan_blocks of the plain program, or of a compaction one whose
+// input is another type), then the block totals of type 'type' with the plain program
+void scanLevels(Runtime& rt, cl::Kernel& blocks, const char* type, size_t size, const cl::Buffer& in,
+	const cl::Buffer& out, size_t n, bool inclusive, const void* threshold, size_t thresholdSize)
+{
+	const size_t local = scanLocal(blocks, rt.device());
+	const size_t block = local * ITEMS;
+	const size_t groups = (n + block - 1) / block;
+	cl::Buffer sums(rt.context(), CL_MEM_READ_WRITE, groups * size);
+
+	blocks.setArg(0, static_cast<cl_ulong>(n));
+	blocks.setArg(1, in);
+	blocks.setArg(2, out);
+	blocks.setArg(3, sums);
+	blocks.setArg(4, thresholdSize, threshold);
+	blocks.setArg(5, static_cast<cl_uint>(inclusive));
+	blocks.setArg(6, cl::Local(local * size));
+	rt.queue().enqueueNDRangeKernel(blocks, cl::NullRange, groups * local, local);
+
+	if (groups > 1)
+	{
+		// Offsets of the blocks, the level above
+		scanCL_Buffer(rt, type, size, sums, sums, groups, false);
+		cl::Kernel add(rt.program(kernelScan, std::string("-DT=") + type), "add_offsets");
+		add.setArg(0, static_cast<cl_ulong>(n));
+		add.setArg(1, static_cast<cl_ulong>(block));
+		add.setArg(2, out);
+		add.setArg(3, sums);
+		rt.queue().enqueueNDRangeKernel(add, cl::NullRange, n, cl::NullRange);
+	}
+}
+
+} // namespace
+
+void scanCL_Buffer(Runtime& rt, const char* type, size_t size, const cl::Buffer& in, const cl::Buffer& out,
+	size_t n, bool inclusive)
+{
+	if (!n)
+		return;
+	const uint64_t zero = 0;
+	cl::Kernel blocks(rt.program(kernelScan, std::string("-DT=") + type), "scan_blocks");
+	scanLevels(rt, blocks, type, size, in, out, n, inclusive, &zero, size);
+}
+
+size_t compactCL_Buffer(Runtime& rt, const char* type, size_t size, const cl::Buffer& in, size_t n,
+	const CompactFilter& filter, const void* threshold, const cl::Buffer& out, const cl::Buffer& indices)
+{
+	if (!n)
+		return 0;
+
+	// Positions count kept elements, in 32 bits while they fit
+	const bool narrow = n <= UINT32_MAX;
+	const char* count = narrow ? "uint" : "ulong";
+	const size_t countSize = narrow ? sizeof(cl_uint) : sizeof(cl_ulong);
+
+	std::string options = std::string("-DT=") + count + " -DIN_T=" + type;
+	if (filter.finite)
+		options += " -DKEEP_FINITE";
+	if (filter.above)
+		options += " -DKEEP_ABOVE";
+	if (!filter.finite && !filter.above)
+		options += " -DKEEP_ALL";
+	cl::Program program = rt.program(kernelScan, options);
+
+	// Inclusive count of the kept elements up to each one: its position + 1
+	cl::Buffer positions(rt.context(), CL_MEM_READ_WRITE, n * countSize);
+	cl::Kernel blocks(program, "scan_blocks");
+	scanLevels(rt, blocks, count, countSize, in, positions, n, true, threshold, size);
+
+	cl::Kernel scatter(program, "compact_scatter");
+	scatter.setArg(0, static_cast<cl_ulong>(n));
+	scatter.setArg(1, in);
+	scatter.setArg(2, positions);
+	scatter.setArg(3, size, threshold);
+	scatter.setArg(4, out);
+	scatter.setArg(5, indices);
+	const cl::CommandQueue& queue = rt.queue();
+	queue.enqueueNDRangeKernel(scatter, cl::NullRange, n, cl::NullRange);
+
+	// The last position is the count
+	if (narrow)
+	{
+		cl_uint kept = 0;
+		queue.enqueueReadBuffer(positions, CL_TRUE, (n - 1) * countSize, countSize, &kept);
+		return kept;
+	}
+	cl_ulong kept = 0;
+	queue.enqueueReadBuffer(positions, CL_TRUE, (n - 1) * countSize, countSize, &kept);
+	return static_cast<size_t>(kept);
+}
@@ -0,0 +1,88 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "device_vector.h"
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class Runtime;
+
+// Prefix sums of n elements of OpenCL C type 'type' ('size' bytes each) from 'in' to 'out',
+// which may be the same buffer. A multi-level block scan: every work-group scans a block and
+// keeps its total, the totals are scanned the same way (recursively) and added back, which
+// needs no forward progress guarantee between work-groups. Enqueued on the runtime's queue.
+void scanCL_Buffer(Runtime& rt, const char* type, size_t size, const cl::Buffer& in, const cl::Buffer& out,
+	size_t n, bool inclusive);
+
+// Elements kept by a compaction; the tests need a floating point type
+struct CompactFilter
+{
+	bool finite{ true };      // drop NaN and infinities
+	bool above{ false };      // keep values greater than 'threshold' only
+	double threshold{ 0.0 };
+};
+
+// Kept elements of the n in 'in', in order, to the front of 'out' and their indices to the
+// front of 'indices' (if it is not null), both of n elements. 'threshold' points to the
+// threshold in the element type. Returns the number kept; blocking for that count only.
+size_t compactCL_Buffer(Runtime& rt, const char* type, size_t size, const cl::Buffer& in, size_t n,
+	const CompactFilter& filter, const void* threshold, const cl::Buffer& out, const cl::Buffer& indices);
+
+namespace ocl {
+
+template<class T>
+void inclusiveScan(const DeviceVector<T>& in, DeviceVector<T>& out)
+{
+	if (in.size() != out.size())
+		throw std::invalid_argument("Scan of " + std::to_string(in.size()) + " elements into " + std::to_string(out.size()));
+	scanCL_Buffer(in.runtime(), ClType<T>::name(), sizeof(T), in.buffer(), out.bufferForWriting(), in.size(), true);
+}
+
+template<class T>
+void exclusiveScan(const DeviceVector<T>& in, DeviceVector<T>& out)
+{
+	if (in.size() != out.size())
+		throw std::invalid_argument("Scan of " + std::to_string(in.size()) + " elements into " + std::to_string(out.size()));
+	scanCL_Buffer(in.runtime(), ClType<T>::name(), sizeof(T), in.buffer(), out.bufferForWriting(), in.size(), false);
+}
+
+// Elements of v which pass 'filter', in order, with their indices in 'indices' if it is not
+// null. Only those elements are read back.
+template<class T>
+std::vector<T> compact(const DeviceVector<T>& v, const CompactFilter& filter, std::vector<size_t>* indices = nullptr)
+{
+	Runtime& rt = v.runtime();
+	const size_t n = v.size();
+	if (!n)
+	{
+		if (indices)
+			indices->clear();
+		return std::vector<T>();
+	}
+
+	const T threshold = static_cast<T>(filter.threshold);
+	cl::Buffer out(rt.context(), CL_MEM_READ_WRITE, n * sizeof(T));
+	cl::Buffer found = indices ? cl::Buffer(rt.context(), CL_MEM_READ_WRITE, n * sizeof(cl_ulong)) : cl::Buffer();
+	const size_t kept = compactCL_Buffer(rt, ClType<T>::name(), sizeof(T), v.buffer(), n, filter, &threshold, out, found);
+
+	std::vector<T> values(kept);
+	if (kept)
+		rt.queue().enqueueReadBuffer(out, CL_TRUE, 0, kept * sizeof(T), values.data());
+	if (indices)
+	{
+		std::vector<uint64_t> at(kept);
+		if (kept)
+			rt.queue().enqueueReadBuffer(found, CL_TRUE, 0, kept * sizeof(cl_ulong), at.data());
+		indices->assign(at.begin(), at.end());
+	}
+	return values;
+}
+
+} // namespace ocl
+
+#endif // SCAN_H
@@ -0,0 +1,56 @@
+#include "staged_pow.h"
+#include "profiling.h"
+#include "runtime.h"
+
+#include <vector>
+
+void powCL_Staged(Runtime& rt, cl::Kernel& kernel, size_t elementSize, const ToDevice& toDevice,
+	const FromDevice& fromDevice, const double* a, const double* b, double* c, size_t n, Profiler* profiler,
+	const std::string& name)
+{
+	if (!n)
+		return;
+
+	const cl::Context& context = rt.context();
+	cl::CommandQueue queue = (profiler && !rt.profiling())
+		? cl::CommandQueue(context, rt.device(), CL_QUEUE_PROFILING_ENABLE) : rt.queue();
+
+	const size_t bytes = n * elementSize;
+	std::vector<unsigned char> hostA(bytes), hostB(b ? bytes : 0);
+
+	cl::Buffer A(context, CL_MEM_READ_ONLY, bytes);
+	cl::Buffer B;
+	cl::Buffer C(context, CL_MEM_WRITE_ONLY, bytes);
+
+	// The upload of a overlaps the conversion of b
+	std::vector<cl::Event> uploaded(b ? 2 : 1);
+	toDevice(a, hostA.data(), n);
+	queue.enqueueWriteBuffer(A, CL_FALSE, 0, bytes, hostA.data(), nullptr, &uploaded[0]);
+	if (b)
+	{
+		B = cl::Buffer(context, CL_MEM_READ_ONLY, bytes);
+		toDevice(b, hostB.data(), n);
+		queue.enqueueWriteBuffer(B, CL_FALSE, 0, bytes, hostB.data(), nullptr, &uploaded[1]);
+	}
+
+	kernel.setArg(0, static_cast<cl_ulong>(n));
+	kernel.setArg(1, A);
+	if (b)
+		kernel.setArg(2, B);
+	kernel.setArg(3, C);
+
+	cl::Event computed, downloaded;
+	queue.enqueueNDRangeKernel(kernel, cl::NullRange, n, cl::NullRange, nullptr, &computed);
+	// In order queue: the upload from hostA is complete before the result lands in it
+	queue.enqueueReadBuffer(C, CL_TRUE, 0, bytes, hostA.data(), nullptr, &downloaded);
+	fromDevice(hostA.data(), c, n);
+
+	if (profiler)
+	{
+		profiler->record(name + " write A", Profiler::Write, uploaded[0], bytes);
+		if (b)
+			profiler->record(name + " write B", Profiler::Write, uploaded[1], bytes);
+		profiler->record(name + " entry_point", Profiler::Kernel, computed, n);
+		profiler->record(name + " read C", Profiler::Read, downloaded, bytes);
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef STAGED_POW_H
+#define STAGED_POW_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+class Profiler;
+class Runtime;
+
+// Conversion of n doubles to the device format at 'dst', and of n device values back
+typedef std::function<void(const double* src, void* dst, size_t n)> ToDevice;
+typedef std::function<void(const void* src, double* dst, size_t n)> FromDevice;
+
+// c[i] = pow(a[i], b[i]) with 'kernel', of parameters (ulong n, global A, B or the exponent,
+// global C), on operands of 'elementSize' bytes per value on the device. The host converts a
+// and b into staging memory and uploads them, the upload of a overlapping the conversion of b;
+// c comes back through the same staging memory and is converted. With a null 'b' the caller
+// has set argument 2 to the exponent. With a 'profiler' the transfers and the kernel are
+// recorded, named after 'name', on a profiling queue.
+void powCL_Staged(Runtime& rt, cl::Kernel& kernel, size_t elementSize, const ToDevice& toDevice,
+	const FromDevice& fromDevice, const double* a, const double* b, double* c, size_t n, Profiler* profiler,
+	const std::string& name);
+
+#endif // STAGED_POW_H
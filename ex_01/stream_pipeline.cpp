@@ -0,0 +1,91 @@
+#include "stream_pipeline.h"
+#include "profiling.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One set of in-flight buffers
+struct Slot
+{
+	cl::Buffer A, B, C;
+	cl::Kernel kernel;
+	cl::Event released; // readback of the last chunk which used the slot
+};
+
+} // namespace
+
+void powCL_Stream(const cl::Context& context, const cl::Device& device, const cl::Program& program,
+	const double* a, const double* b, double* c, size_t n, size_t chunkElems, unsigned depth,
+	Profiler* profiler)
+{
+	if (!n)
+		return;
+	if (!depth)
+		throw std::invalid_argument("Stream depth must be positive.");
+
+	size_t maxChunk = static_cast<size_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()) / sizeof(double);
+	size_t chunk = std::min(std::min(chunkElems ? chunkElems : n, maxChunk), n);
+	size_t chunks = (n + chunk - 1) / chunk;
+	depth = static_cast<unsigned>(std::min<size_t>(depth, chunks));
+
+	// A queue per stage: in-order inside a stage, stages overlap each other
+	cl_command_queue_properties props = profiler ? CL_QUEUE_PROFILING_ENABLE : 0;
+	cl::CommandQueue upload(context, device, props);
+	cl::CommandQueue compute(context, device, props);
+	cl::CommandQueue readback(context, device, props);
+
+	const size_t bytes = chunk * sizeof(double);
+	std::vector<Slot> slots(depth);
+	for (auto& s : slots)
+	{
+		s.A = cl::Buffer(context, CL_MEM_READ_ONLY, bytes);
+		s.B = cl::Buffer(context, CL_MEM_READ_ONLY, bytes);
+		s.C = cl::Buffer(context, CL_MEM_WRITE_ONLY, bytes);
+		s.kernel = cl::Kernel(program, "entry_point");
+		s.kernel.setArg(1, s.A);
+		s.kernel.setArg(2, s.B);
+		s.kernel.setArg(3, s.C);
+	}
+
+	for (size_t k = 0; k < chunks; ++k)
+	{
+		Slot& s = slots[k % depth];
+		const size_t offset = k * chunk;
+		const size_t count = std::min(chunk, n - offset);
+		const size_t size = count * sizeof(double);
+
+		// Don't overwrite the slot's inputs before its previous chunk has been consumed
+		std::vector<cl::Event> free;
+		if (s.released())
+			free.push_back(s.released);
+
+		std::vector<cl::Event> uploaded(2);
+		upload.enqueueWriteBuffer(s.A, CL_FALSE, 0, size, a + offset, &free, &uploaded[0]);
+		upload.enqueueWriteBuffer(s.B, CL_FALSE, 0, size, b + offset, &free, &uploaded[1]);
+
+		std::vector<cl::Event> computed(1);
+		s.kernel.setArg(0, static_cast<cl_ulong>(count));
+		compute.enqueueNDRangeKernel(s.kernel, cl::NullRange, count, cl::NullRange, &uploaded, &computed[0]);
+
+		readback.enqueueReadBuffer(s.C, CL_FALSE, 0, size, c + offset, &computed, &s.released);
+
+		if (profiler)
+		{
+			const std::string chunkName = " #" + std::to_string(k);
+			profiler->record("write A" + chunkName, Profiler::Write, uploaded[0], size, 0);
+			profiler->record("write B" + chunkName, Profiler::Write, uploaded[1], size, 0);
+			profiler->record("entry_point" + chunkName, Profiler::Kernel, computed[0], count, 1);
+			profiler->record("read C" + chunkName, Profiler::Read, s.released, size, 2);
+		}
+
+		upload.flush();
+		compute.flush();
+		readback.flush();
+	}
+
+	readback.finish();
+}
@@ -0,0 +1,21 @@
+#ifndef STREAM_PIPELINE_H
+#define STREAM_PIPELINE_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+
+class Profiler;
+
+// c[i] = pow(a[i], b[i]) over n elements, streamed through the device in chunks.
+// 'depth' buffer sets rotate between an upload, a compute and a readback queue, chained with
+// events, so the upload of chunk k+1 overlaps the kernel of chunk k and the readback of chunk k-1.
+// Chunks are clamped to CL_DEVICE_MAX_MEM_ALLOC_SIZE, hence n itself is not limited by it.
+// 'program' must provide kernel1's "entry_point".
+// With a 'profiler' the stage queues are created with profiling enabled and every command is
+// recorded on lanes 0 (upload), 1 (compute) and 2 (readback).
+void powCL_Stream(const cl::Context& context, const cl::Device& device, const cl::Program& program,
+	const double* a, const double* b, double* c, size_t n, size_t chunkElems, unsigned depth = 3,
+	Profiler* profiler = nullptr);
+
+#endif // STREAM_PIPELINE_H
@@ -0,0 +1,55 @@
+#include "utils.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#  define NOMINMAX
+#  include <windows.h>
+#  include <process.h>
+#  include <psapi.h>
+#  pragma comment(lib, "psapi.lib")
+#else
+#  include <sys/resource.h>
+#  include <unistd.h>
+#endif
+
+double peakRSS_MiB()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+	return 0.0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0.0;
+#  if defined(__APPLE__)
+	return usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+#  else
+	return usage.ru_maxrss / 1024.0; // KiB
+#  endif
+#endif
+}
+
+std::string tempPathFor(const std::string& path)
+{
+#if defined(_WIN32)
+	const long pid = _getpid();
+#else
+	const long pid = getpid();
+#endif
+	return path + "." + std::to_string(pid) + ".tmp";
+}
+
+bool replaceFile(const std::string& tmp, const std::string& path)
+{
+#if defined(_WIN32)
+	// rename doesn't replace an existing file there; elsewhere it does, atomically
+	std::remove(path.c_str());
+#endif
+	if (std::rename(tmp.c_str(), path.c_str()) == 0)
+		return true;
+	std::remove(tmp.c_str());
+	return false;
+}
@@ -0,0 +1,159 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include "ocl_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// Wall clock stopwatch for host side measurements
+class Stopwatch
+{
+public:
+	Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+	void restart() { m_start = std::chrono::steady_clock::now(); }
+
+	double elapsedMs() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point m_start;
+};
+
+const uint64_t FNV1A64_OFFSET = 0xcbf29ce484222325ULL;
+
+// 64-bit FNV-1a, chainable through the seed
+inline uint64_t fnv1a64(const std::string& data, uint64_t h = FNV1A64_OFFSET)
+{
+	for (unsigned char ch : data)
+	{
+		h ^= ch;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+inline std::string toHex(uint64_t v)
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string s(16, '0');
+	for (int i = 15; i >= 0; --i, v >>= 4)
+		s[i] = digits[v & 0xF];
+	return s;
+}
+
+// Quotes and backslashes escaped for a JSON string literal
+inline std::string jsonEscape(const std::string& s)
+{
+	std::string out;
+	for (char ch : s)
+	{
+		if (ch == '"' || ch == '\\')
+			out += '\\';
+		out += ch;
+	}
+	return out;
+}
+
+// Nearest-rank percentile, p in [0, 100]
+inline double percentile(std::vector<double> samples, double p)
+{
+	if (samples.empty())
+		return 0.0;
+	size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+	return samples[rank];
+}
+
+// Median time of 'reps' runs of 'run' after a warm-up run (program builds, first touches),
+// each preceded by 'reset', which isn't timed
+inline double medianMs(const std::function<void()>& run, int reps, const std::function<void()>& reset = {})
+{
+	std::vector<double> ms;
+	for (int r = 0; r <= reps; ++r)
+	{
+		if (reset)
+			reset();
+		Stopwatch sw;
+		run();
+		if (r)
+			ms.push_back(sw.elapsedMs());
+	}
+	return percentile(ms, 50.0);
+}
+
+// 'n' lowered to the elements of 'elementSize' bytes one allocation on 'device' can hold
+inline size_t clampToAlloc(const cl::Device& device, size_t n, size_t elementSize = sizeof(double))
+{
+	const size_t maxAlloc = static_cast<size_t>(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>());
+	return std::min(n, maxAlloc / elementSize);
+}
+
+// 'n' values uniform in [lo, hi), the same for the same seed, so that runs compare
+inline std::vector<double> randomVector(size_t n, double lo, double hi, uint64_t seed = 0)
+{
+	std::vector<double> v(n);
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<double> value(lo, hi);
+	for (double& x : v)
+		x = value(rng);
+	return v;
+}
+
+// Distance between two doubles in units in the last place, 0 for equal values or two NaNs,
+// the maximum when only one of them is a NaN
+inline uint64_t ulpDistance(double a, double b)
+{
+	if (std::isnan(a) || std::isnan(b))
+		return (std::isnan(a) && std::isnan(b)) ? 0 : std::numeric_limits<uint64_t>::max();
+
+	// Map the bit patterns onto a monotonic integer line, -0 and +0 meet at zero
+	auto ordered = [](double v) -> int64_t {
+		int64_t i;
+		std::memcpy(&i, &v, sizeof(i));
+		return i < 0 ? std::numeric_limits<int64_t>::min() - i : i;
+	};
+	int64_t ia = ordered(a), ib = ordered(b);
+	return ia > ib ? static_cast<uint64_t>(ia) - static_cast<uint64_t>(ib)
+		: static_cast<uint64_t>(ib) - static_cast<uint64_t>(ia);
+}
+
+// Error of 'value' against a more precise 'exact' in units of the last place of a double at
+// 'exact': fractional, 0 for matching infinities or NaNs, infinite for a mismatch among them
+inline double ulpError(double value, long double exact)
+{
+	if (std::isnan(value) || std::isnan(exact))
+		return (std::isnan(value) && std::isnan(exact)) ? 0.0 : std::numeric_limits<double>::infinity();
+	if (std::isinf(value) || std::isinf(static_cast<double>(exact)))
+		return value == static_cast<double>(exact) ? 0.0 : std::numeric_limits<double>::infinity();
+
+	int e = 0;
+	std::frexp(static_cast<double>(exact), &e);
+	const long double ulp = std::ldexp(1.0L, std::max(e - 53, -1074));
+	return static_cast<double>(std::fabs(value - exact) / ulp);
+}
+
+// Peak resident set size of the process so far, in MiB (0 when unknown)
+double peakRSS_MiB();
+
+// Name to write 'path' aside under before replaceFile(), unique to the process so concurrent
+// writers don't clobber each other's
+std::string tempPathFor(const std::string& path);
+
+// Rename 'tmp' over 'path', so a concurrent reader sees either file but never a partial or
+// missing one (except on Windows, where the old one is removed first). 'tmp' is removed when
+// the rename fails.
+bool replaceFile(const std::string& tmp, const std::string& path);
+
+#endif // UTILS_H
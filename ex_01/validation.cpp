@@ -0,0 +1,144 @@
+#include "validation.h"
+#include "kernels.h"
+#include "profiling.h"
+#include "runtime.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// BUCKETS and SUMMARY of kernelValidate
+const size_t BUCKETS = 16;
+const size_t SUMMARY = 5 + BUCKETS;
+
+// Arguments of "validate" before those of the expected expression
+const cl_uint LEAF_ARG = 7;
+
+double fromBits(uint64_t bits)
+{
+	double v;
+	std::memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+// Largest power of two not above n, at least 1
+size_t floorPow2(size_t n)
+{
+	size_t p = 1;
+	while (p * 2 <= n)
+		p *= 2;
+	return p;
+}
+
+} // namespace
+
+uint64_t ValidationSummary::maxUlp() const
+{
+	size_t last = ulpHistogram.size();
+	while (last && !ulpHistogram[last - 1])
+		--last;
+	if (last == ulpHistogram.size())
+		return UINT64_MAX;
+	return last ? (uint64_t(1) << (last - 1)) - 1 : 0;
+}
+
+std::string toString(const ValidationSummary& s)
+{
+	std::ostringstream out;
+	out << s.n << " elements, max abs error " << s.maxAbsError << ", max rel error " << s.maxRelError
+		<< ", ULP histogram";
+	for (size_t k = 0; k < s.ulpHistogram.size(); ++k)
+	{
+		if (!s.ulpHistogram[k])
+			continue;
+		out << ' ';
+		if (k == 0)
+			out << '0';
+		else if (k == 1)
+			out << '1';
+		else if (k + 1 < s.ulpHistogram.size())
+			out << (uint64_t(1) << (k - 1)) << '-' << (uint64_t(1) << k) - 1;
+		else
+			out << ">=" << (uint64_t(1) << (k - 1));
+		out << ':' << s.ulpHistogram[k];
+	}
+	out << ", " << s.nans << " NaN, " << s.infinities << " inf, hash " << toHex(s.hash);
+	return out.str();
+}
+
+uint64_t contentHash(const double* values, size_t n)
+{
+	uint64_t hash = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		uint64_t z;
+		std::memcpy(&z, &values[i], sizeof(z));
+		z ^= static_cast<uint64_t>(i) * 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		hash += z ^ (z >> 31);
+	}
+	return hash;
+}
+
+ValidationSummary validateCL_Buffer(Runtime& rt, const cl::Buffer& values, size_t n, const std::string& params,
+	const std::string& expected, const std::function<void(cl::Kernel&, uint32_t&)>& setArgs,
+	Profiler* profiler)
+{
+	ValidationSummary summary;
+	summary.n = n;
+	if (!n)
+		return summary;
+
+	// The expected expression goes in as macros, one program per expression shape
+	const std::string source = "#define EXPECTED_PARAMS " + params + "\n"
+		"#define EXPECTED(i) ((double)" + expected + ")\n" + kernelValidate;
+	cl::Kernel kernel(rt.program(source), "validate");
+
+	// A few work-groups per compute unit, but few enough elements per work-group for uint counts
+	const cl::Device& device = rt.device();
+	const size_t local = floorPow2(std::min<size_t>(256, kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device)));
+	const size_t perGroup = size_t(1) << 31;
+	const size_t groups = std::max(std::min<size_t>(4 * device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>(),
+		(n + local - 1) / local), (n + perGroup - 1) / perGroup);
+
+	cl::Buffer partial(rt.context(), CL_MEM_WRITE_ONLY, groups * SUMMARY * sizeof(cl_ulong));
+	kernel.setArg(0, static_cast<cl_ulong>(n));
+	kernel.setArg(1, values);
+	kernel.setArg(2, partial);
+	kernel.setArg(3, cl::Local(local * sizeof(cl_double)));
+	kernel.setArg(4, cl::Local(local * sizeof(cl_double)));
+	kernel.setArg(5, cl::Local(local * sizeof(cl_ulong)));
+	kernel.setArg(6, cl::Local((BUCKETS + 2) * sizeof(cl_uint)));
+	cl_uint arg = LEAF_ARG;
+	setArgs(kernel, arg);
+
+	const cl::CommandQueue& queue = rt.queue();
+	cl::Event compared, summed;
+	queue.enqueueNDRangeKernel(kernel, cl::NullRange, groups * local, local, nullptr, &compared);
+	std::vector<uint64_t> partials(groups * SUMMARY);
+	const size_t bytes = partials.size() * sizeof(cl_ulong);
+	queue.enqueueReadBuffer(partial, CL_TRUE, 0, bytes, partials.data(), nullptr, &summed);
+	if (profiler)
+	{
+		profiler->record("validate", Profiler::Kernel, compared, n);
+		profiler->record("read summaries", Profiler::Read, summed, bytes);
+	}
+
+	for (size_t g = 0; g < groups; ++g)
+	{
+		const uint64_t* p = &partials[g * SUMMARY];
+		summary.maxAbsError = std::max(summary.maxAbsError, fromBits(p[0]));
+		summary.maxRelError = std::max(summary.maxRelError, fromBits(p[1]));
+		summary.hash += p[2];
+		summary.nans += p[3];
+		summary.infinities += p[4];
+		for (size_t k = 0; k < BUCKETS; ++k)
+			summary.ulpHistogram[k] += p[5 + k];
+	}
+	return summary;
+}
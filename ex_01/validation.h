@@ -0,0 +1,76 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include "device_vector.h"
+#include "expression.h"
+#include "ocl_common.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+class Profiler;
+class Runtime;
+
+// Comparison of computed doubles with their expected values, without reading them back
+struct ValidationSummary
+{
+	size_t n{ 0 };
+	double maxAbsError{ 0.0 };  // over pairs of finite values
+	double maxRelError{ 0.0 };  // the same relative to |expected|, infinite for a miss of an expected 0
+	// Elements by ULP distance (see ulpDistance() in utils.h): [0] equal, both NaN or the same
+	// infinity, [k] 2^(k-1) to 2^k - 1, [15] 2^14 and more or a mismatch involving NaN or infinity
+	std::array<uint64_t, 16> ulpHistogram{};
+	uint64_t nans{ 0 };         // among the values
+	uint64_t infinities{ 0 };
+	uint64_t hash{ 0 };         // contentHash() of the values
+
+	// Upper bound of the ULP distances: 2^k - 1 for the last bucket k in use, UINT64_MAX for [15]
+	uint64_t maxUlp() const;
+};
+
+std::string toString(const ValidationSummary& s);
+
+// Hash of the bit patterns of n doubles and their positions, the one validation computes on the
+// device: a sum of mixed (bits, index) pairs, so the order of summation doesn't matter
+uint64_t contentHash(const double* values, size_t n);
+
+// Compare the n doubles in 'values' with the expression whose kernel parameters are 'params' and
+// element i 'expected' (as generated by fusedSource()); 'setArgs' passes its leaves from the
+// argument it is given. kernelValidate leaves one summary per work-group, for a few work-groups
+// per compute unit, which are combined on the host: the readback is a few KiB whatever n is.
+// Blocking. The kernel and the readback are recorded to 'profiler', if given.
+ValidationSummary validateCL_Buffer(Runtime& rt, const cl::Buffer& values, size_t n, const std::string& params,
+	const std::string& expected, const std::function<void(cl::Kernel&, uint32_t&)>& setArgs,
+	Profiler* profiler = nullptr);
+
+namespace ocl {
+
+// Validate v against an expression of its size or of scalars, computed alongside the comparison
+template<class E>
+ValidationSummary validate(const DeviceVector<double>& v, const Expression<E>& expected,
+	Profiler* profiler = nullptr)
+{
+	typedef typename Stored<E>::type Node;
+	const Node node(expected.self());
+	if (node.size() && node.size() != v.size())
+		throw std::invalid_argument("Validating " + std::to_string(v.size()) + " elements against "
+			+ std::to_string(node.size()));
+
+	const std::pair<std::string, std::string>& source = fusedSource<Node>();
+	return validateCL_Buffer(v.runtime(), v.buffer(), v.size(), source.first, source.second,
+		[&node](cl::Kernel& kernel, uint32_t& arg) { node.setArgs(kernel, arg); }, profiler);
+}
+
+// Validate v against a constant
+inline ValidationSummary validate(const DeviceVector<double>& v, double expected, Profiler* profiler = nullptr)
+{
+	return validate(v, Scalar<double>(expected), profiler);
+}
+
+} // namespace ocl
+
+#endif // VALIDATION_H
@@ -0,0 +1,177 @@
+#include "work_stealing.h"
+#include "kernels.h"
+#include "profiling.h"
+#include "program_cache.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Tiles each device keeps queued, one running and one ready to start
+const size_t TILES_IN_FLIGHT = 2;
+
+struct Tile
+{
+	cl::Buffer A, B, C;
+	cl::Event first, second, computed, last;
+	size_t count;
+};
+
+// Command of a worker for the profiler, which only the calling thread may touch
+struct Record
+{
+	std::string name;
+	Profiler::Kind kind;
+	cl::Event event;
+	size_t amount;
+};
+
+} // namespace
+
+WorkStealingScheduler::WorkStealingScheduler(const std::vector<cl::Device>& devices)
+{
+	if (devices.empty())
+		throw std::domain_error("No devices for the work-stealing scheduler.");
+
+	m_context = cl::Context(devices);
+	for (auto& d : devices)
+	{
+		Lane lane;
+		lane.device = d;
+		lane.queue = cl::CommandQueue(m_context, d, CL_QUEUE_PROFILING_ENABLE);
+		lane.kernel = cl::Kernel(buildCL_Program(m_context, d, kernel1), "entry_point");
+		m_lanes.push_back(lane);
+	}
+}
+
+void WorkStealingScheduler::run(const double* a, const double* b, double* c, size_t n, size_t tileElems,
+	Profiler* profiler)
+{
+	m_stats.assign(m_lanes.size(), DeviceStats());
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+		m_stats[i].name = m_lanes[i].device.getInfo<CL_DEVICE_NAME>();
+	if (!n)
+		return;
+
+	const size_t tile = std::min(tileElems ? tileElems : n, n);
+	const size_t tiles = (n + tile - 1) / tile;
+	std::atomic<size_t> next(0);
+	std::vector<std::exception_ptr> errors(m_lanes.size());
+	std::vector<std::vector<Record>> records(m_lanes.size());
+
+	auto worker = [&](size_t i) {
+		try {
+			Lane& lane = m_lanes[i];
+			DeviceStats& st = m_stats[i];
+			const size_t tileBytes = tile * sizeof(double);
+
+			// One buffer set per queued tile; the queue is in order, so a set can be reissued
+			// as soon as its previous tile has been collected
+			std::vector<Tile> slots(TILES_IN_FLIGHT);
+			for (auto& s : slots)
+			{
+				s.A = cl::Buffer(m_context, CL_MEM_READ_ONLY, tileBytes);
+				s.B = cl::Buffer(m_context, CL_MEM_READ_ONLY, tileBytes);
+				s.C = cl::Buffer(m_context, CL_MEM_WRITE_ONLY, tileBytes);
+			}
+			std::deque<size_t> inFlight;
+			size_t issued = 0;
+
+			for (;;)
+			{
+				// Keep the device fed while there are tiles left
+				while (inFlight.size() < TILES_IN_FLIGHT)
+				{
+					size_t t = next.fetch_add(1);
+					if (t >= tiles)
+						break;
+
+					const size_t offset = t * tile;
+					const size_t slot = issued++ % TILES_IN_FLIGHT;
+					Tile& job = slots[slot];
+					job.count = std::min(tile, n - offset);
+					const size_t bytes = job.count * sizeof(double);
+
+					lane.queue.enqueueWriteBuffer(job.A, CL_FALSE, 0, bytes, a + offset, nullptr, &job.first);
+					lane.queue.enqueueWriteBuffer(job.B, CL_FALSE, 0, bytes, b + offset, nullptr, &job.second);
+					lane.kernel.setArg(0, static_cast<cl_ulong>(job.count));
+					lane.kernel.setArg(1, job.A);
+					lane.kernel.setArg(2, job.B);
+					lane.kernel.setArg(3, job.C);
+					lane.queue.enqueueNDRangeKernel(lane.kernel, cl::NullRange, job.count, cl::NullRange, nullptr,
+						&job.computed);
+					lane.queue.enqueueReadBuffer(job.C, CL_FALSE, 0, bytes, c + offset, nullptr, &job.last);
+					lane.queue.flush();
+					inFlight.push_back(slot);
+
+					if (profiler)
+					{
+						const std::string tileName = " #" + std::to_string(t);
+						records[i].push_back({ "write A" + tileName, Profiler::Write, job.first, bytes });
+						records[i].push_back({ "write B" + tileName, Profiler::Write, job.second, bytes });
+						records[i].push_back({ "entry_point" + tileName, Profiler::Kernel, job.computed, job.count });
+						records[i].push_back({ "read C" + tileName, Profiler::Read, job.last, bytes });
+					}
+				}
+
+				if (inFlight.empty())
+					break;
+
+				Tile& done = slots[inFlight.front()];
+				done.last.wait();
+				st.tiles += 1;
+				st.elements += done.count;
+				st.busyMs += eventSpanMs(done.first, done.last);
+				inFlight.pop_front();
+			}
+		}
+		catch (...) {
+			errors[i] = std::current_exception();
+		}
+	};
+
+	Stopwatch sw;
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < m_lanes.size(); ++i)
+		threads.push_back(std::thread(worker, i));
+	for (auto& t : threads)
+		t.join();
+	const double wallMs = sw.elapsedMs();
+
+	for (auto& e : errors)
+	{
+		if (e)
+			std::rethrow_exception(e);
+	}
+	for (auto& st : m_stats)
+		st.idleMs = std::max(0.0, wallMs - st.busyMs);
+
+	if (profiler)
+	{
+		for (size_t i = 0; i < records.size(); ++i)
+		{
+			for (auto& r : records[i])
+				profiler->record(r.name, r.kind, r.event, r.amount, static_cast<int>(i));
+		}
+	}
+}
+
+void WorkStealingScheduler::printStats(std::ostream& os) const
+{
+	for (size_t i = 0; i < m_stats.size(); ++i)
+	{
+		const DeviceStats& st = m_stats[i];
+		os << "[" << i << "] " << st.name
+			<< " || TILES: " << st.tiles
+			<< " || ELEMENTS: " << st.elements
+			<< " || BUSY: " << st.busyMs << " ms"
+			<< " || IDLE: " << st.idleMs << " ms\n";
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Profiler;
+
+// c[i] = pow(a[i], b[i]) balanced dynamically across devices.
+// The range is cut into tiles handed out by a shared lock-free counter. Every device has a host
+// thread which pulls the next tile as soon as one of its in-flight tiles completes, so a device
+// which slows down (throttling, sharing) simply takes fewer tiles.
+class WorkStealingScheduler
+{
+public:
+	struct DeviceStats
+	{
+		std::string name;
+		size_t tiles;
+		size_t elements;
+		double busyMs;  // device time spent on the tiles
+		double idleMs;  // rest of the run's wall time
+	};
+
+	explicit WorkStealingScheduler(const std::vector<cl::Device>& devices);
+
+	// The transfers and kernels of every tile are recorded to 'profiler', if given, one trace row
+	// per device
+	void run(const double* a, const double* b, double* c, size_t n, size_t tileElems, Profiler* profiler = nullptr);
+
+	// Per device statistics of the last run
+	const std::vector<DeviceStats>& stats() const { return m_stats; }
+	void printStats(std::ostream& os) const;
+
+private:
+	struct Lane
+	{
+		cl::Device device;
+		cl::CommandQueue queue;
+		cl::Kernel kernel;
+	};
+
+	cl::Context m_context;
+	std::vector<Lane> m_lanes;
+	std::vector<DeviceStats> m_stats;
+};
+
+#endif // WORK_STEALING_H
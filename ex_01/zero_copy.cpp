@@ -0,0 +1,174 @@
+#include "zero_copy.h"
+#include "profiling.h"
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#ifdef _WIN32
+#  include <malloc.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace {
+
+size_t pageSize()
+{
+#ifdef _WIN32
+	return 4096;
+#else
+	long size = sysconf(_SC_PAGESIZE);
+	return size > 0 ? static_cast<size_t>(size) : 4096;
+#endif
+}
+
+struct PageDeleter
+{
+	void operator()(void* ptr) const { freePageAligned(ptr); }
+};
+
+typedef std::unique_ptr<double, PageDeleter> PageArray;
+
+PageArray allocArray(size_t n)
+{
+	return PageArray(static_cast<double*>(allocPageAligned(n * sizeof(double))));
+}
+
+// Wrap page aligned host arrays, the device works on the host copy itself
+void runUseHostPtr(const cl::Context& context, const cl::CommandQueue& queue, cl::Kernel& kernel,
+	size_t n, const ZeroCopyFill& fill, const ZeroCopyConsume& consume, Profiler* profiler)
+{
+	const size_t bytes = n * sizeof(double);
+	PageArray a = allocArray(n), b = allocArray(n), c = allocArray(n);
+	fill(a.get(), b.get(), n);
+
+	cl::Buffer A(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes, a.get());
+	cl::Buffer B(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes, b.get());
+	cl::Buffer C(context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, bytes, c.get());
+
+	kernel.setArg(1, A);
+	kernel.setArg(2, B);
+	kernel.setArg(3, C);
+	cl::Event computed, mapC, unmapC;
+	queue.enqueueNDRangeKernel(kernel, cl::NullRange, n, cl::NullRange, nullptr, &computed);
+
+	// Mapping is what makes the result coherent on the host, it returns c itself
+	auto mapped = static_cast<const double*>(queue.enqueueMapBuffer(C, CL_TRUE, CL_MAP_READ, 0, bytes,
+		nullptr, &mapC));
+	consume(mapped, n);
+	queue.enqueueUnmapMemObject(C, const_cast<double*>(mapped), nullptr, &unmapC);
+	queue.finish();
+
+	if (profiler)
+	{
+		profiler->record("entry_point", Profiler::Kernel, computed, n);
+		profiler->record("map C", Profiler::Read, mapC, bytes);
+		profiler->record("unmap C", Profiler::Other, unmapC, 0);
+	}
+}
+
+// Let the driver place the buffers where both sides reach them, fill and read through maps
+void runAllocHostPtr(const cl::Context& context, const cl::CommandQueue& queue, cl::Kernel& kernel,
+	size_t n, const ZeroCopyFill& fill, const ZeroCopyConsume& consume, Profiler* profiler)
+{
+	const size_t bytes = n * sizeof(double);
+	cl::Buffer A(context, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR, bytes);
+	cl::Buffer B(context, CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR, bytes);
+	cl::Buffer C(context, CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, bytes);
+
+	cl::Event mapA, mapB, unmapA, unmapB, computed, mapC, unmapC;
+	auto a = static_cast<double*>(queue.enqueueMapBuffer(A, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, bytes,
+		nullptr, &mapA));
+	auto b = static_cast<double*>(queue.enqueueMapBuffer(B, CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, bytes,
+		nullptr, &mapB));
+	fill(a, b, n);
+	queue.enqueueUnmapMemObject(A, a, nullptr, &unmapA);
+	queue.enqueueUnmapMemObject(B, b, nullptr, &unmapB);
+
+	kernel.setArg(1, A);
+	kernel.setArg(2, B);
+	kernel.setArg(3, C);
+	queue.enqueueNDRangeKernel(kernel, cl::NullRange, n, cl::NullRange, nullptr, &computed);
+
+	auto c = static_cast<const double*>(queue.enqueueMapBuffer(C, CL_TRUE, CL_MAP_READ, 0, bytes, nullptr, &mapC));
+	consume(c, n);
+	queue.enqueueUnmapMemObject(C, const_cast<double*>(c), nullptr, &unmapC);
+	queue.finish();
+
+	if (profiler)
+	{
+		profiler->record("map A", Profiler::Other, mapA, 0);
+		profiler->record("map B", Profiler::Other, mapB, 0);
+		profiler->record("unmap A", Profiler::Write, unmapA, bytes);
+		profiler->record("unmap B", Profiler::Write, unmapB, bytes);
+		profiler->record("entry_point", Profiler::Kernel, computed, n);
+		profiler->record("map C", Profiler::Read, mapC, bytes);
+		profiler->record("unmap C", Profiler::Other, unmapC, 0);
+	}
+}
+
+} // namespace
+
+const char* toString(ZeroCopyMode mode)
+{
+	switch (mode)
+	{
+	case ZeroCopyMode::Auto:
+		return "AUTO";
+	case ZeroCopyMode::UseHostPtr:
+		return "USE_HOST_PTR";
+	case ZeroCopyMode::AllocHostPtr:
+		return "ALLOC_HOST_PTR";
+	}
+	return "";
+}
+
+void* allocPageAligned(size_t bytes)
+{
+	const size_t page = pageSize();
+	bytes = (bytes + page - 1) / page * page;
+	if (!bytes)
+		bytes = page;
+#ifdef _WIN32
+	void* ptr = _aligned_malloc(bytes, page);
+#else
+	void* ptr = nullptr;
+	if (posix_memalign(&ptr, page, bytes) != 0)
+		ptr = nullptr;
+#endif
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void freePageAligned(void* ptr)
+{
+#ifdef _WIN32
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+ZeroCopyMode powCL_ZeroCopy(const cl::Context& context, const cl::Device& device,
+	const cl::CommandQueue& queue, const cl::Program& program, size_t n,
+	const ZeroCopyFill& fill, const ZeroCopyConsume& consume, ZeroCopyMode mode, Profiler* profiler)
+{
+	if (mode == ZeroCopyMode::Auto)
+	{
+		// Shared physical memory: the host arrays can be used as is.
+		// Discrete memory: pinned driver allocations are the cheapest to reach from both sides.
+		mode = device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() ? ZeroCopyMode::UseHostPtr : ZeroCopyMode::AllocHostPtr;
+	}
+
+	cl::Kernel kernel(program, "entry_point");
+	kernel.setArg(0, static_cast<cl_ulong>(n));
+
+	if (mode == ZeroCopyMode::UseHostPtr)
+		runUseHostPtr(context, queue, kernel, n, fill, consume, profiler);
+	else
+		runAllocHostPtr(context, queue, kernel, n, fill, consume, profiler);
+
+	return mode;
+}
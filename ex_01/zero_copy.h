@@ -0,0 +1,37 @@
+#ifndef ZERO_COPY_H
+#define ZERO_COPY_H
+
+#include "ocl_common.h"
+
+#include <cstddef>
+#include <functional>
+
+class Profiler;
+
+enum class ZeroCopyMode {
+	Auto,         // pick from CL_DEVICE_HOST_UNIFIED_MEMORY
+	UseHostPtr,   // page aligned host arrays wrapped by the buffers
+	AllocHostPtr  // driver allocated (pinned) buffers, accessed through map/unmap
+};
+
+const char* toString(ZeroCopyMode mode);
+
+// Page aligned host allocation, size rounded up to whole pages as CL_MEM_USE_HOST_PTR prefers
+void* allocPageAligned(size_t bytes);
+void freePageAligned(void* ptr);
+
+// Fills the inputs, host side, in place
+typedef std::function<void(double* a, double* b, size_t n)> ZeroCopyFill;
+// Consumes the result while it is mapped
+typedef std::function<void(const double* c, size_t n)> ZeroCopyConsume;
+
+// c[i] = pow(a[i], b[i]) without staging copies: the host writes the inputs and reads the result
+// through memory the device accesses directly. Returns the mode actually used.
+// 'program' must provide kernel1's "entry_point". With a profiler, 'queue' must have
+// CL_QUEUE_PROFILING_ENABLE; the maps, unmaps and the kernel are recorded.
+ZeroCopyMode powCL_ZeroCopy(const cl::Context& context, const cl::Device& device,
+	const cl::CommandQueue& queue, const cl::Program& program, size_t n,
+	const ZeroCopyFill& fill, const ZeroCopyConsume& consume, ZeroCopyMode mode = ZeroCopyMode::Auto,
+	Profiler* profiler = nullptr);
+
+#endif // ZERO_COPY_H